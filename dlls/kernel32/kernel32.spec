@@ -239,6 +239,7 @@
 @ stdcall CommConfigDialogW(wstr long ptr)
 # @ stub CompareCalendarDates
 @ stdcall -import CompareFileTime(ptr ptr)
+@ stdcall -import CompareObjectHandles(long long)
 @ stdcall -import CompareStringA(long long str long str long)
 @ stdcall -import CompareStringEx(wstr long wstr long wstr long ptr ptr long)
 @ stdcall -import CompareStringOrdinal(wstr long wstr long long)
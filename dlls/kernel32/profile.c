@@ -57,6 +57,9 @@ typedef struct tagPROFILESECTION
 {
     struct tagPROFILEKEY       *key;
     struct tagPROFILESECTION   *next;
+    struct tagPROFILEKEY      **key_hash;  /* hash table of the keys, built on demand */
+    unsigned int                key_hash_size;
+    unsigned int                key_hash_count;
     WCHAR                       name[1];
 } PROFILESECTION;
 
@@ -73,6 +76,9 @@ typedef struct
 
 #define N_CACHED_PROFILES 10
 
+/* Minimum number of keys in a section to build a hash table for it */
+#define MIN_HASHED_KEYS 16
+
 /* Cached profile files */
 static PROFILE *MRUProfile[N_CACHED_PROFILES]={NULL};
 
@@ -263,6 +269,7 @@ static void PROFILE_Free( PROFILESECTION *section )
             HeapFree( GetProcessHeap(), 0, key );
         }
         next_section = section->next;
+        HeapFree( GetProcessHeap(), 0, section->key_hash );
         HeapFree( GetProcessHeap(), 0, section );
     }
 }
@@ -394,6 +401,8 @@ static PROFILESECTION *PROFILE_Load(HANDLE hFile, ENCODING * pEncoding)
     first_section->name[0] = 0;
     first_section->key  = NULL;
     first_section->next = NULL;
+    first_section->key_hash = NULL;
+    first_section->key_hash_size = first_section->key_hash_count = 0;
     next_section = &first_section->next;
     next_key     = &first_section->key;
     prev_key     = NULL;
@@ -432,6 +441,8 @@ static PROFILESECTION *PROFILE_Load(HANDLE hFile, ENCODING * pEncoding)
                 section->name[len] = '\0';
                 section->key  = NULL;
                 section->next = NULL;
+                section->key_hash = NULL;
+                section->key_hash_size = section->key_hash_count = 0;
                 *next_section = section;
                 next_section  = &section->next;
                 next_key      = &section->key;
@@ -489,6 +500,99 @@ static PROFILESECTION *PROFILE_Load(HANDLE hFile, ENCODING * pEncoding)
 }
 
 
+/***********************************************************************
+ *           PROFILE_HashName
+ */
+static unsigned int PROFILE_HashName( const WCHAR *name, int len )
+{
+    unsigned int hash = 0;
+
+    while (len--) hash = hash * 65599 + tolowerW( *name++ );
+    return hash;
+}
+
+
+/***********************************************************************
+ *           PROFILE_FreeKeyHash
+ */
+static void PROFILE_FreeKeyHash( PROFILESECTION *section )
+{
+    HeapFree( GetProcessHeap(), 0, section->key_hash );
+    section->key_hash = NULL;
+    section->key_hash_size = section->key_hash_count = 0;
+}
+
+
+/***********************************************************************
+ *           PROFILE_HashKey
+ *
+ * Add a key to the hash table of its section. Only the first key of a
+ * given name is added, since that is the one lookups have to return.
+ */
+static void PROFILE_HashKey( PROFILESECTION *section, PROFILEKEY *key )
+{
+    unsigned int mask = section->key_hash_size - 1;
+    unsigned int pos = PROFILE_HashName( key->name, strlenW(key->name) ) & mask;
+
+    if ((section->key_hash_count + 1) * 2 > section->key_hash_size)
+    {
+        /* too full, rebuild it on the next lookup */
+        PROFILE_FreeKeyHash( section );
+        return;
+    }
+
+    while (section->key_hash[pos])
+    {
+        if (!strcmpiW( section->key_hash[pos]->name, key->name )) return;
+        pos = (pos + 1) & mask;
+    }
+    section->key_hash[pos] = key;
+    section->key_hash_count++;
+}
+
+
+/***********************************************************************
+ *           PROFILE_BuildKeyHash
+ *
+ * Build the hash table of a section if it has enough keys to make it worthwhile.
+ */
+static BOOL PROFILE_BuildKeyHash( PROFILESECTION *section )
+{
+    unsigned int count = 0, size = 32;
+    PROFILEKEY *key;
+
+    for (key = section->key; key; key = key->next) count++;
+    if (count < MIN_HASHED_KEYS) return FALSE;
+
+    while (size < count * 4) size *= 2;
+    if (!(section->key_hash = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, size * sizeof(*section->key_hash) )))
+        return FALSE;
+    section->key_hash_size = size;
+    section->key_hash_count = 0;
+
+    for (key = section->key; key; key = key->next) PROFILE_HashKey( section, key );
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           PROFILE_FindHashedKey
+ */
+static PROFILEKEY *PROFILE_FindHashedKey( const PROFILESECTION *section, LPCWSTR key_name, int keylen )
+{
+    unsigned int mask = section->key_hash_size - 1;
+    unsigned int pos = PROFILE_HashName( key_name, keylen ) & mask;
+    PROFILEKEY *key;
+
+    while ((key = section->key_hash[pos]))
+    {
+        if (!strncmpiW( key->name, key_name, keylen ) && key->name[keylen] == '\0') return key;
+        pos = (pos + 1) & mask;
+    }
+    return NULL;
+}
+
+
 /***********************************************************************
  *           PROFILE_DeleteSection
  *
@@ -530,6 +634,7 @@ static BOOL PROFILE_DeleteKey( PROFILESECTION **section,
                 if (!strcmpiW( (*key)->name, key_name ))
                 {
                     PROFILEKEY *to_del = *key;
+                    PROFILE_FreeKeyHash( *section );
                     *key = to_del->next;
                     HeapFree( GetProcessHeap(), 0, to_del->value);
                     HeapFree( GetProcessHeap(), 0, to_del );
@@ -557,6 +662,7 @@ static void PROFILE_DeleteAllKeys( LPCWSTR section_name)
         if (!strcmpiW( (*section)->name, section_name ))
         {
             PROFILEKEY **key = &(*section)->key;
+            PROFILE_FreeKeyHash( *section );
             while (*key)
             {
                 PROFILEKEY *to_del = *key;
@@ -604,6 +710,14 @@ static PROFILEKEY *PROFILE_Find( PROFILESECTION **section, LPCWSTR section_name,
             ((*section)->name)[seclen] == '\0')
         {
             PROFILEKEY **key = &(*section)->key;
+            BOOL hashed = FALSE;
+
+            if (!create_always && ((*section)->key_hash || PROFILE_BuildKeyHash( *section )))
+            {
+                PROFILEKEY *found = PROFILE_FindHashedKey( *section, key_name, keylen );
+                if (found || !create) return found;
+                hashed = TRUE;
+            }
 
             while (*key)
             {
@@ -612,7 +726,7 @@ static PROFILEKEY *PROFILE_Find( PROFILESECTION **section, LPCWSTR section_name,
                  * existence, to allow keys to be added more than once in
                  * some cases.
                  */
-                if(!create_always)
+                if(!create_always && !hashed)
                 {
                     if ( (!(strncmpiW( (*key)->name, key_name, keylen )))
                          && (((*key)->name)[keylen] == '\0') )
@@ -626,6 +740,7 @@ static PROFILEKEY *PROFILE_Find( PROFILESECTION **section, LPCWSTR section_name,
             strcpyW( (*key)->name, key_name );
             (*key)->value = NULL;
             (*key)->next  = NULL;
+            if ((*section)->key_hash) PROFILE_HashKey( *section, *key );
             return *key;
         }
         section = &(*section)->next;
@@ -635,6 +750,8 @@ static PROFILEKEY *PROFILE_Find( PROFILESECTION **section, LPCWSTR section_name,
     if(*section == NULL) return NULL;
     strcpyW( (*section)->name, section_name );
     (*section)->next = NULL;
+    (*section)->key_hash = NULL;
+    (*section)->key_hash_size = (*section)->key_hash_count = 0;
     if (!((*section)->key  = HeapAlloc( GetProcessHeap(), 0,
                                         sizeof(PROFILEKEY) + strlenW(key_name) * sizeof(WCHAR) )))
     {
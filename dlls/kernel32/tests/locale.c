@@ -1826,6 +1826,10 @@ static const struct comparestringa_entry comparestringa_data[] = {
   { LOCALE_SYSTEM_DEFAULT, 0, "a", 2, "a\0x", 4, CSTR_LESS_THAN },
   { LOCALE_SYSTEM_DEFAULT, 0, "a\0x", 4, "a", 1, CSTR_GREATER_THAN },
   { LOCALE_SYSTEM_DEFAULT, 0, "a\0x", 4, "a", 2, CSTR_GREATER_THAN },
+  { LOCALE_SYSTEM_DEFAULT, 0, "abcdefB", -1, "abcdefb", -1, CSTR_GREATER_THAN },
+  { LOCALE_SYSTEM_DEFAULT, 0, "abcdef1", -1, "abcdef2", -1, CSTR_LESS_THAN },
+  { LOCALE_SYSTEM_DEFAULT, 0, "abcdef", -1, "abcdefg", -1, CSTR_LESS_THAN },
+  { LOCALE_SYSTEM_DEFAULT, NORM_IGNORECASE, "abcdefB", -1, "abcdefb", -1, CSTR_EQUAL },
 };
 
 static void test_CompareStringA(void)
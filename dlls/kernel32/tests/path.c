@@ -1908,7 +1908,7 @@ static void test_SearchPathW(void)
     static const WCHAR extW[] = {'.','e','x','t',0};
     static const WCHAR dllW[] = {'.','d','l','l',0};
     static const WCHAR fileW[] = { 0 };
-    WCHAR pathW[MAX_PATH], buffW[MAX_PATH], path2W[MAX_PATH];
+    WCHAR pathW[MAX_PATH], buffW[MAX_PATH], path2W[MAX_PATH], path3W[3 * MAX_PATH];
     WCHAR *ptrW = NULL;
     ULONG_PTR cookie;
     HANDLE handle;
@@ -1949,6 +1949,18 @@ if (0)
     ret = SearchPathW(pathW, fileext2W, NULL, ARRAY_SIZE(buffW), buffW, NULL);
     ok(ret && ret == lstrlenW(path2W), "got %d\n", ret);
 
+    /* duplicate entries in the search path */
+    GetWindowsDirectoryW(buffW, ARRAY_SIZE(buffW));
+    lstrcpyW(path3W, buffW);
+    lstrcatW(path3W, L";");
+    lstrcatW(path3W, buffW);
+    lstrcatW(path3W, L"\\;");
+    lstrcatW(path3W, pathW);
+    buffW[0] = 0;
+    ret = SearchPathW(path3W, fileext2W, NULL, ARRAY_SIZE(buffW), buffW, NULL);
+    ok(ret && ret == lstrlenW(path2W), "got %d\n", ret);
+    ok(!lstrcmpiW(buffW, path2W), "got %s\n", wine_dbgstr_w(buffW));
+
     DeleteFileW(path2W);
 
     GetWindowsDirectoryW(pathW, ARRAY_SIZE(pathW));
@@ -502,6 +502,52 @@ static void create_test_file(LPCSTR name, LPCSTR data, DWORD size)
     CloseHandle(hfile);
 }
 
+static void test_profile_many_keys(void)
+{
+    static const CHAR testfile[] = ".\\winetest_many.ini";
+    char contents[4096], name[32], value[32];
+    int i, len;
+    UINT res;
+    BOOL ret;
+
+    len = sprintf(contents, "[" SECTION "]\r\n");
+    for (i = 0; i < 100; i++)
+        len += sprintf(contents + len, "key%d=%d\r\n", i, i);
+    create_test_file(testfile, contents, len);
+
+    for (i = 0; i < 100; i++)
+    {
+        sprintf(name, "Key%d", i);
+        res = GetPrivateProfileIntA(SECTION, name, -1, testfile);
+        ok(res == i, "%s: got %d\n", name, res);
+    }
+    res = GetPrivateProfileIntA(SECTION, "key100", -1, testfile);
+    ok(res == -1, "got %d\n", res);
+
+    for (i = 100; i < 200; i++)
+    {
+        sprintf(name, "key%d", i);
+        sprintf(value, "%d", i);
+        ret = WritePrivateProfileStringA(SECTION, name, value, testfile);
+        ok(ret, "%s: WritePrivateProfileString failed\n", name);
+    }
+    for (i = 0; i < 200; i++)
+    {
+        sprintf(name, "KEY%d", i);
+        res = GetPrivateProfileIntA(SECTION, name, -1, testfile);
+        ok(res == i, "%s: got %d\n", name, res);
+    }
+
+    ret = WritePrivateProfileStringA(SECTION, "key5", NULL, testfile);
+    ok(ret, "WritePrivateProfileString failed\n");
+    res = GetPrivateProfileIntA(SECTION, "key5", -1, testfile);
+    ok(res == -1, "got %d\n", res);
+    res = GetPrivateProfileIntA(SECTION, "key6", -1, testfile);
+    ok(res == 6, "got %d\n", res);
+
+    DeleteFileA(testfile);
+}
+
 static BOOL emptystr_ok(CHAR emptystr[MAX_PATH])
 {
     int i;
@@ -1101,6 +1147,7 @@ START_TEST(profile)
     test_profile_existing();
     test_profile_delete_on_close();
     test_profile_refresh();
+    test_profile_many_keys();
     test_profile_directory_readonly();
     test_GetPrivateProfileString(
         "[section1]\r\n"
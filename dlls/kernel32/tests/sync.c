@@ -3156,6 +3156,64 @@ static void test_zigzag_event(void)
     trace("count: %d\n", zigzag_count[0]);
 }
 
+#define BROADCAST_WAITERS 256
+
+static LONG broadcast_ready, broadcast_woken;
+
+static DWORD CALLBACK broadcast_waiter(void *arg)
+{
+    HANDLE *events = arg;
+    DWORD ret;
+
+    InterlockedIncrement(&broadcast_ready);
+    ret = WaitForSingleObject(events[0], 10000);
+    ok(ret == WAIT_OBJECT_0, "wait failed: %u\n", ret);
+    if (InterlockedIncrement(&broadcast_woken) == BROADCAST_WAITERS) SetEvent(events[1]);
+    return 0;
+}
+
+static void test_event_broadcast(void)
+{
+    /* Wake up many threads waiting on a manual-reset event at once, and
+     * print the time it takes until all of them have run. */
+
+    HANDLE threads[BROADCAST_WAITERS], events[2];
+    LARGE_INTEGER start, end, freq;
+    DWORD ret;
+    int i;
+
+    events[0] = CreateEventA(NULL, TRUE, FALSE, NULL);
+    events[1] = CreateEventA(NULL, FALSE, FALSE, NULL);
+    broadcast_ready = broadcast_woken = 0;
+
+    for (i = 0; i < BROADCAST_WAITERS; i++)
+    {
+        threads[i] = CreateThread(NULL, 0, broadcast_waiter, events, 0, NULL);
+        ok(threads[i] != NULL, "CreateThread failed: %u\n", GetLastError());
+    }
+    while (broadcast_ready < BROADCAST_WAITERS) Sleep(10);
+    Sleep(100);  /* let the threads block */
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    SetEvent(events[0]);
+    ret = WaitForSingleObject(events[1], 10000);
+    QueryPerformanceCounter(&end);
+    ok(ret == WAIT_OBJECT_0, "wait failed: %u\n", ret);
+    ok(broadcast_woken == BROADCAST_WAITERS, "woke up %d threads\n", broadcast_woken);
+    trace("woke up %d threads in %u us\n", broadcast_woken,
+          (DWORD)((end.QuadPart - start.QuadPart) * 1000000 / freq.QuadPart));
+
+    for (i = 0; i < BROADCAST_WAITERS; i++)
+    {
+        ret = WaitForSingleObject(threads[i], 10000);
+        ok(ret == WAIT_OBJECT_0, "wait failed: %u\n", ret);
+        CloseHandle(threads[i]);
+    }
+    CloseHandle(events[0]);
+    CloseHandle(events[1]);
+}
+
 START_TEST(sync)
 {
     char **argv;
@@ -3219,5 +3277,6 @@ START_TEST(sync)
     test_alertable_wait();
     test_apc_deadlock();
     test_zigzag_event();
+    test_event_broadcast();
     test_crit_section();
 }
@@ -3048,6 +3048,19 @@ INT WINAPI CompareStringEx( const WCHAR *locale, DWORD flags, const WCHAR *str1,
     if (len1 < 0) len1 = lstrlenW(str1);
     if (len2 < 0) len2 = lstrlenW(str2);
 
+    if (len1 == len2 && !memcmp( str1, str2, len1 * sizeof(WCHAR) )) return CSTR_EQUAL;
+
+    /* ASCII letters and digits have non-zero weights and no special rules, so a common
+     * prefix of them compares equal in every pass and can be skipped */
+    while (len1 && len2 && *str1 == *str2 &&
+           ((*str1 >= '0' && *str1 <= '9') || ((*str1 | 0x20) >= 'a' && (*str1 | 0x20) <= 'z')))
+    {
+        str1++;
+        str2++;
+        len1--;
+        len2--;
+    }
+
     ret = compare_weights( flags, str1, len1, str2, len2, UNICODE_WEIGHT );
     if (!ret)
     {
@@ -339,6 +339,17 @@ BOOL WINAPI DECLSPEC_HOTPATCH CloseHandle( HANDLE handle )
 }
 
 
+/*********************************************************************
+ *           CompareObjectHandles   (kernelbase.@)
+ */
+BOOL WINAPI DECLSPEC_HOTPATCH CompareObjectHandles( HANDLE first, HANDLE second )
+{
+    if (is_console_handle( first )) first = console_handle_map( first );
+    if (is_console_handle( second )) second = console_handle_map( second );
+    return set_ntstatus( NtCompareObjects( first, second ));
+}
+
+
 /**********************************************************************
  *           CreateProcessAsUserA   (kernelbase.@)
  */
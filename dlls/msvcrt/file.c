@@ -2824,6 +2824,21 @@ static int read_i(int fd, ioinfo *fdinfo, void *buf, unsigned int count)
 
             for (i=0, j=0; i<num_read; i+=1+utf16)
             {
+                if (!utf16)
+                {
+                    /* move runs of characters that need no translation in one go */
+                    DWORD k = i;
+
+                    while (k<num_read && bufstart[k]!='\r' && bufstart[k]!=0x1a) k++;
+                    if (k != i)
+                    {
+                        if (j != i) memmove(bufstart+j, bufstart+i, k-i);
+                        j += k-i;
+                        i = k;
+                        if (i == num_read) break;
+                    }
+                }
+
                 /* in text mode, a ctrl-z signals EOF */
                 if (bufstart[i]==0x1a && (!utf16 || bufstart[i+1]==0))
                 {
@@ -3790,10 +3805,28 @@ char * CDECL MSVCRT_fgets(char *s, int size, MSVCRT_FILE* file)
 
   MSVCRT__lock_file(file);
 
-  while ((size >1) && (cc = MSVCRT__fgetc_nolock(file)) != MSVCRT_EOF && cc != '\n')
+  while (size > 1)
     {
+      if (file->_cnt > 0)
+        {
+          /* copy straight from the stream buffer up to the end of the line */
+          int len = min(file->_cnt, size - 1);
+          char *nl = memchr(file->_ptr, '\n', len);
+
+          if (nl) len = nl - file->_ptr + 1;
+          memcpy(s, file->_ptr, len);
+          file->_cnt -= len;
+          file->_ptr += len;
+          s += len;
+          size -= len;
+          cc = (unsigned char)s[-1];
+          if (nl) break;
+          continue;
+        }
+      if ((cc = MSVCRT__fgetc_nolock(file)) == MSVCRT_EOF) break;
       *s++ = (char)cc;
-      size --;
+      size--;
+      if (cc == '\n') break;
     }
   if ((cc == MSVCRT_EOF) && (s == buf_start)) /* If nothing read, return 0*/
   {
@@ -3801,8 +3834,6 @@ char * CDECL MSVCRT_fgets(char *s, int size, MSVCRT_FILE* file)
     MSVCRT__unlock_file(file);
     return NULL;
   }
-  if ((cc != MSVCRT_EOF) && (size > 1))
-    *s++ = cc;
   *s = '\0';
   TRACE(":got %s\n", debugstr_a(buf_start));
   MSVCRT__unlock_file(file);
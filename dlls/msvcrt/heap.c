@@ -41,7 +41,7 @@ WINE_DEFAULT_DEBUG_CHANNEL(msvcrt);
 
 #define SB_HEAP_ALIGN 16
 
-static HANDLE heap, sb_heap;
+static HANDLE heap;
 
 typedef int (CDECL *MSVCRT_new_handler_func)(MSVCRT_size_t size);
 
@@ -53,50 +53,206 @@ static unsigned int MSVCRT_amblksiz = 16;
 /* FIXME - According to documentation it should be 480 bytes, at runtime default is 0 */
 static MSVCRT_size_t MSVCRT_sbh_threshold = 0;
 
-static void* msvcrt_heap_alloc(DWORD flags, MSVCRT_size_t size)
+#ifndef _WIN64
+
+/* Small blocks heap: blocks of the same size are carved out of 64k regions
+ * and recycled through per-size free lists. A bitmap of the regions is used
+ * to tell small blocks apart from regular heap blocks. Each thread keeps a
+ * few freed blocks of each size, the shared lists are only used when its
+ * cache is empty or full. */
+#define SB_REGION_SIZE 0x10000
+#define SB_MAX_SIZE 1024
+#define SB_CACHE_MAX 32
+#define SB_CACHE_REFILL 16
+
+struct sb_region
 {
-    if(size < MSVCRT_sbh_threshold)
+    MSVCRT_size_t block_size;
+    char *next;
+};
+
+struct sb_thread_cache
+{
+    void *free_list[SB_MAX_SIZE / SB_HEAP_ALIGN];
+    unsigned int count[SB_MAX_SIZE / SB_HEAP_ALIGN];
+};
+
+static BYTE sb_regions[0x10000 / 8];
+static struct sb_region *sb_current[SB_MAX_SIZE / SB_HEAP_ALIGN];
+static void *sb_free_list[SB_MAX_SIZE / SB_HEAP_ALIGN];
+
+static inline BOOL sb_is_block(const void *ptr)
+{
+    DWORD_PTR region = (DWORD_PTR)ptr / SB_REGION_SIZE;
+    return (sb_regions[region / 8] >> (region % 8)) & 1;
+}
+
+static inline MSVCRT_size_t sb_block_size(const void *ptr)
+{
+    return ((struct sb_region *)((DWORD_PTR)ptr & ~(DWORD_PTR)(SB_REGION_SIZE - 1)))->block_size;
+}
+
+static struct sb_thread_cache *sb_get_thread_cache(void)
+{
+    thread_data_t *data = msvcrt_get_thread_data();
+
+    if (!data->sb_cache)
+        data->sb_cache = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*data->sb_cache));
+    return data->sb_cache;
+}
+
+static void *sb_alloc(DWORD flags, MSVCRT_size_t size)
+{
+    unsigned int idx = size ? (size - 1) / SB_HEAP_ALIGN : 0;
+    MSVCRT_size_t block_size = (idx + 1) * SB_HEAP_ALIGN;
+    struct sb_thread_cache *cache = sb_get_thread_cache();
+    struct sb_region *region;
+    void *ret;
+
+    if (cache && (ret = cache->free_list[idx]))
     {
-        void *memblock, *temp, **saved;
+        cache->free_list[idx] = *(void **)ret;
+        cache->count[idx]--;
+        if (flags & HEAP_ZERO_MEMORY) memset(ret, 0, block_size);
+        return ret;
+    }
 
-        temp = HeapAlloc(sb_heap, flags, size+sizeof(void*)+SB_HEAP_ALIGN);
-        if(!temp) return NULL;
+    LOCK_HEAP;
+    if ((ret = sb_free_list[idx]))
+    {
+        sb_free_list[idx] = *(void **)ret;
+        if (flags & HEAP_ZERO_MEMORY) memset(ret, 0, block_size);
+
+        /* move some more blocks to the thread cache for the next allocations */
+        while (cache && cache->count[idx] < SB_CACHE_REFILL && sb_free_list[idx])
+        {
+            void *block = sb_free_list[idx];
+
+            sb_free_list[idx] = *(void **)block;
+            *(void **)block = cache->free_list[idx];
+            cache->free_list[idx] = block;
+            cache->count[idx]++;
+        }
+    }
+    else
+    {
+        region = sb_current[idx];
+        if (!region || region->next + block_size > (char *)region + SB_REGION_SIZE)
+        {
+            DWORD_PTR pos;
+
+            /* regions are 64k aligned, and freshly allocated memory is already zeroed */
+            if (!(region = VirtualAlloc(NULL, SB_REGION_SIZE, MEM_COMMIT, PAGE_READWRITE)))
+            {
+                UNLOCK_HEAP;
+                return NULL;
+            }
+            region->block_size = block_size;
+            region->next = (char *)region + SB_HEAP_ALIGN;
+            pos = (DWORD_PTR)region / SB_REGION_SIZE;
+            sb_regions[pos / 8] |= 1 << (pos % 8);
+            sb_current[idx] = region;
+        }
+        ret = region->next;
+        region->next += block_size;
+    }
+    UNLOCK_HEAP;
+    return ret;
+}
 
-        memblock = ALIGN_PTR(temp, SB_HEAP_ALIGN, 0);
-        saved = SAVED_PTR(memblock);
-        *saved = temp;
-        return memblock;
+/* move the blocks of a thread cache list to the shared free list, heap lock must be held */
+static void sb_flush_cache_list(struct sb_thread_cache *cache, unsigned int idx)
+{
+    void **tail;
+
+    if (!cache->free_list[idx]) return;
+    for (tail = cache->free_list[idx]; *tail; tail = *tail);
+    *tail = sb_free_list[idx];
+    sb_free_list[idx] = cache->free_list[idx];
+    cache->free_list[idx] = NULL;
+    cache->count[idx] = 0;
+}
+
+static void sb_free(void *ptr)
+{
+    unsigned int idx = sb_block_size(ptr) / SB_HEAP_ALIGN - 1;
+    struct sb_thread_cache *cache = sb_get_thread_cache();
+
+    if (cache && cache->count[idx] < SB_CACHE_MAX)
+    {
+        *(void **)ptr = cache->free_list[idx];
+        cache->free_list[idx] = ptr;
+        cache->count[idx]++;
+        return;
     }
 
+    LOCK_HEAP;
+    *(void **)ptr = sb_free_list[idx];
+    sb_free_list[idx] = ptr;
+    if (cache) sb_flush_cache_list(cache, idx);
+    UNLOCK_HEAP;
+}
+
+void msvcrt_free_heap_cache(thread_data_t *data)
+{
+    unsigned int idx;
+
+    if (!data->sb_cache) return;
+    LOCK_HEAP;
+    for (idx = 0; idx < ARRAY_SIZE(data->sb_cache->free_list); idx++)
+        sb_flush_cache_list(data->sb_cache, idx);
+    UNLOCK_HEAP;
+    HeapFree(GetProcessHeap(), 0, data->sb_cache);
+    data->sb_cache = NULL;
+}
+
+static void sb_destroy(void)
+{
+    DWORD_PTR pos;
+
+    for (pos = 0; pos < ARRAY_SIZE(sb_regions) * 8; pos++)
+    {
+        if (!((sb_regions[pos / 8] >> (pos % 8)) & 1)) continue;
+        VirtualFree((void *)(pos * SB_REGION_SIZE), 0, MEM_RELEASE);
+    }
+}
+
+#else
+
+static inline BOOL sb_is_block(const void *ptr) { return FALSE; }
+static inline MSVCRT_size_t sb_block_size(const void *ptr) { return 0; }
+static inline void *sb_alloc(DWORD flags, MSVCRT_size_t size) { return NULL; }
+static inline void sb_free(void *ptr) { }
+static inline void sb_destroy(void) { }
+void msvcrt_free_heap_cache(thread_data_t *data) { }
+
+#endif
+
+static void* msvcrt_heap_alloc(DWORD flags, MSVCRT_size_t size)
+{
+    if(size < MSVCRT_sbh_threshold)
+        return sb_alloc(flags, size);
+
     return HeapAlloc(heap, flags, size);
 }
 
 static void* msvcrt_heap_realloc(DWORD flags, void *ptr, MSVCRT_size_t size)
 {
-    if(sb_heap && ptr && !HeapValidate(heap, 0, ptr))
+    if(sb_is_block(ptr))
     {
-        /* TODO: move data to normal heap if it exceeds sbh_threshold limit */
-        void *memblock, *temp, **saved;
-        MSVCRT_size_t old_padding, new_padding, old_size;
-
-        saved = SAVED_PTR(ptr);
-        old_padding = (char*)ptr - (char*)*saved;
-        old_size = HeapSize(sb_heap, 0, *saved);
-        if(old_size == -1)
-            return NULL;
-        old_size -= old_padding;
-
-        temp = HeapReAlloc(sb_heap, flags, *saved, size+sizeof(void*)+SB_HEAP_ALIGN);
-        if(!temp) return NULL;
+        MSVCRT_size_t old_size = sb_block_size(ptr);
+        void *memblock;
 
-        memblock = ALIGN_PTR(temp, SB_HEAP_ALIGN, 0);
-        saved = SAVED_PTR(memblock);
-        new_padding = (char*)memblock - (char*)temp;
+        if(size <= old_size)
+            return ptr;
+        if(flags & HEAP_REALLOC_IN_PLACE_ONLY)
+            return NULL;
 
-        if(new_padding != old_padding)
-            memmove(memblock, (char*)temp+old_padding, old_size>size ? size : old_size);
+        memblock = msvcrt_heap_alloc(flags, size);
+        if(!memblock) return NULL;
 
-        *saved = temp;
+        memcpy(memblock, ptr, old_size);
+        sb_free(ptr);
         return memblock;
     }
 
@@ -105,10 +261,10 @@ static void* msvcrt_heap_realloc(DWORD flags, void *ptr, MSVCRT_size_t size)
 
 static BOOL msvcrt_heap_free(void *ptr)
 {
-    if(sb_heap && ptr && !HeapValidate(heap, 0, ptr))
+    if(sb_is_block(ptr))
     {
-        void **saved = SAVED_PTR(ptr);
-        return HeapFree(sb_heap, 0, *saved);
+        sb_free(ptr);
+        return TRUE;
     }
 
     return HeapFree(heap, 0, ptr);
@@ -116,11 +272,8 @@ static BOOL msvcrt_heap_free(void *ptr)
 
 static MSVCRT_size_t msvcrt_heap_size(void *ptr)
 {
-    if(sb_heap && ptr && !HeapValidate(heap, 0, ptr))
-    {
-        void **saved = SAVED_PTR(ptr);
-        return HeapSize(sb_heap, 0, *saved);
-    }
+    if(sb_is_block(ptr))
+        return sb_block_size(ptr);
 
     return HeapSize(heap, 0, ptr);
 }
@@ -243,8 +396,7 @@ void* CDECL _expand(void* mem, MSVCRT_size_t size)
  */
 int CDECL _heapchk(void)
 {
-  if (!HeapValidate(heap, 0, NULL) ||
-          (sb_heap && !HeapValidate(sb_heap, 0, NULL)))
+  if (!HeapValidate(heap, 0, NULL))
   {
     msvcrt_set_errno(GetLastError());
     return MSVCRT__HEAPBADNODE;
@@ -257,8 +409,7 @@ int CDECL _heapchk(void)
  */
 int CDECL _heapmin(void)
 {
-  if (!HeapCompact( heap, 0 ) ||
-          (sb_heap && !HeapCompact( sb_heap, 0 )))
+  if (!HeapCompact( heap, 0 ))
   {
     if (GetLastError() != ERROR_CALL_NOT_IMPLEMENTED)
       msvcrt_set_errno(GetLastError());
@@ -274,7 +425,7 @@ int CDECL _heapwalk(struct MSVCRT__heapinfo* next)
 {
   PROCESS_HEAP_ENTRY phe;
 
-  if (sb_heap)
+  if (MSVCRT_sbh_threshold)
       FIXME("small blocks heap not supported\n");
 
   LOCK_HEAP;
@@ -528,13 +679,6 @@ int CDECL _set_sbh_threshold(MSVCRT_size_t threshold)
   if(threshold > 1016)
      return 0;
 
-  if(!sb_heap)
-  {
-      sb_heap = HeapCreate(0, 0, 0);
-      if(!sb_heap)
-          return 0;
-  }
-
   MSVCRT_sbh_threshold = (threshold+0xf) & ~0xf;
   return 1;
 #endif
@@ -874,6 +1018,5 @@ BOOL msvcrt_init_heap(void)
 void msvcrt_destroy_heap(void)
 {
     HeapDestroy(heap);
-    if(sb_heap)
-        HeapDestroy(sb_heap);
+    sb_destroy();
 }
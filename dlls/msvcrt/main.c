@@ -79,6 +79,7 @@ static inline void msvcrt_free_tls_mem(void)
         free_locinfo(tls->locinfo);
         free_mbcinfo(tls->mbcinfo);
     }
+    msvcrt_free_heap_cache(tls);
   }
   HeapFree(GetProcessHeap(), 0, tls);
 }
@@ -92,6 +92,22 @@ static inline double precise_pow( double x, double y )
     return z;
 }
 
+static inline double precise_square( double x )
+{
+#ifdef __i386__
+    /* compute on the x87 with double precision regardless of the caller's
+     * control word, and store it so that the result is a real double */
+    WORD square_cw = 0x27f, pre_cw;
+    double z;
+    __asm__ __volatile__( "fnstcw %0" : "=m" (pre_cw) );
+    __asm__ __volatile__( "fldcw %1; fldl %2; fmul %%st(0),%%st(0); fstpl %0; fldcw %3"
+                          : "=m" (z) : "m" (square_cw), "m" (x), "m" (pre_cw) );
+    return z;
+#else
+    return x * x;
+#endif
+}
+
 static inline double precise_sinh( double x )
 {
     WORD precise_cw = 0x37f, pre_cw;
@@ -109,6 +125,7 @@ static inline double precise_sinh( double x )
 #define precise_exp  exp
 #define precise_pow  pow
 #define precise_sinh sinh
+#define precise_square(x) ((x) * (x))
 
 #endif
 
@@ -588,7 +605,8 @@ double CDECL MSVCRT_log10( double x )
  */
 double CDECL MSVCRT_pow( double x, double y )
 {
-  double z = precise_pow(x,y);
+  /* squaring is common and is a single correctly rounded multiplication */
+  double z = y == 2.0 ? precise_square(x) : precise_pow(x,y);
   if (x < 0 && y != floor(y)) math_error(_DOMAIN, "pow", x, y, z);
   else if (!x && isfinite(y) && y < 0) math_error(_SING, "pow", x, y, z);
   else if (isfinite(x) && isfinite(y) && !isfinite(z)) math_error(_OVERFLOW, "pow", x, y, z);
@@ -2569,7 +2587,7 @@ void __cdecl MSVCRT___libm_sse2_pow(void)
 {
     double d1, d2;
     __asm__ __volatile__( "movq %%xmm0,%0; movq %%xmm1,%1 " : "=m" (d1), "=m" (d2) );
-    d1 = pow( d1, d2 );
+    d1 = d2 == 2.0 ? precise_square( d1 ) : pow( d1, d2 );
     __asm__ __volatile__( "movq %0,%%xmm0" : : "m" (d1) );
 }
 
@@ -302,6 +302,7 @@ struct __thread_data {
 #if _MSVCR_VER >= 140
     MSVCRT_invalid_parameter_handler invalid_parameter_handler;
 #endif
+    struct sb_thread_cache         *sb_cache;           /* small blocks heap cache */
 };
 
 typedef struct __thread_data thread_data_t;
@@ -375,6 +376,7 @@ extern void msvcrt_free_signals(void) DECLSPEC_HIDDEN;
 extern void msvcrt_free_popen_data(void) DECLSPEC_HIDDEN;
 extern BOOL msvcrt_init_heap(void) DECLSPEC_HIDDEN;
 extern void msvcrt_destroy_heap(void) DECLSPEC_HIDDEN;
+extern void msvcrt_free_heap_cache(thread_data_t*) DECLSPEC_HIDDEN;
 extern void msvcrt_init_clock(void) DECLSPEC_HIDDEN;
 
 #if _MSVCR_VER >= 100
@@ -93,15 +93,16 @@ static inline int FUNC_NAME(pf_fill)(FUNC_NAME(puts_clbk) pf_puts, void *puts_ct
     written = r;
 
     if((!left && flags->LeftAlign) || (left && !flags->LeftAlign)) {
-        APICHAR ch;
+        APICHAR pad[32];
+        int pad_len = flags->FieldLength-len, chunk;
 
-        if(left && flags->PadZero)
-            ch = '0';
-        else
-            ch = ' ';
+        for(i=0; i<pad_len && i<ARRAY_SIZE(pad); i++)
+            pad[i] = left && flags->PadZero ? '0' : ' ';
 
-        for(i=0; i<flags->FieldLength-len && r>=0; i++) {
-            r = pf_puts(puts_ctx, 1, &ch);
+        /* write the padding in chunks instead of one character at a time */
+        for(i=0; i<pad_len && r>=0; i+=chunk) {
+            chunk = pad_len-i < ARRAY_SIZE(pad) ? pad_len-i : ARRAY_SIZE(pad);
+            r = pf_puts(puts_ctx, chunk, pad);
             written += r;
         }
     }
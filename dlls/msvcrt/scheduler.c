@@ -130,6 +130,7 @@ typedef struct {
     int shutdown_size;
     HANDLE *shutdown_events;
     CRITICAL_SECTION cs;
+    PTP_POOL pool;
 } ThreadScheduler;
 extern const vtable_ptr MSVCRT_ThreadScheduler_vtable;
 
@@ -155,6 +156,7 @@ static SchedulerPolicy default_scheduler_policy;
 static ThreadScheduler *default_scheduler;
 
 static void create_default_scheduler(void);
+void __cdecl CurrentScheduler_Detach(void);
 
 static Context* try_get_current_context(void)
 {
@@ -611,6 +613,9 @@ static void ThreadScheduler_dtor(ThreadScheduler *this)
 
     this->cs.DebugInfo->Spare[0] = 0;
     DeleteCriticalSection(&this->cs);
+
+    if(this->pool)
+        CloseThreadpool(this->pool);
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_Id, 4)
@@ -717,18 +722,97 @@ DEFINE_THISCALL_WRAPPER(ThreadScheduler_CreateScheduleGroup, 4)
     return NULL;
 }
 
-DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask_loc, 16)
-void __thiscall ThreadScheduler_ScheduleTask_loc(ThreadScheduler *this,
-        void (__cdecl *proc)(void*), void* data, /*location*/void *placement)
+struct scheduled_task {
+    ThreadScheduler *scheduler;
+    void (__cdecl *proc)(void*);
+    void *data;
+};
+
+static void WINAPI ThreadScheduler_task_proc(TP_CALLBACK_INSTANCE *instance, void *ctx)
 {
-    FIXME("(%p %p %p %p) stub\n", this, proc, data, placement);
+    struct scheduled_task task = *(struct scheduled_task*)ctx;
+    ExternalContextBase *context = (ExternalContextBase*)get_current_context();
+    BOOL attached = FALSE;
+
+    TRACE("running %p(%p) on scheduler %p\n", task.proc, task.data, task.scheduler);
+
+    MSVCRT_operator_delete(ctx);
+
+    /* make tasks scheduled from the task go to the same scheduler */
+    if(context->context.vtable == &MSVCRT_ExternalContextBase_vtable &&
+            context->scheduler.scheduler != &task.scheduler->scheduler) {
+        ThreadScheduler_Attach(task.scheduler);
+        attached = TRUE;
+    }
+
+    task.proc(task.data);
+
+    if(attached)
+        CurrentScheduler_Detach();
+    ThreadScheduler_Release(task.scheduler);
+}
+
+static PTP_POOL ThreadScheduler_get_pool(ThreadScheduler *this)
+{
+    PTP_POOL pool;
+    unsigned int min;
+
+    if(this->pool)
+        return this->pool;
+
+    EnterCriticalSection(&this->cs);
+    if(!this->pool) {
+        if(!(pool = CreateThreadpool(NULL))) {
+            LeaveCriticalSection(&this->cs);
+            throw_exception(EXCEPTION_SCHEDULER_RESOURCE_ALLOCATION_ERROR,
+                    HRESULT_FROM_WIN32(GetLastError()), NULL);
+            return NULL;
+        }
+
+        min = SchedulerPolicy_GetPolicyValue(&this->policy, MinConcurrency);
+        if(min > this->virt_proc_no)
+            min = this->virt_proc_no;
+        SetThreadpoolThreadMaximum(pool, this->virt_proc_no);
+        SetThreadpoolThreadMinimum(pool, min);
+        this->pool = pool;
+    }
+    LeaveCriticalSection(&this->cs);
+    return this->pool;
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask, 12)
 void __thiscall ThreadScheduler_ScheduleTask(ThreadScheduler *this,
         void (__cdecl *proc)(void*), void* data)
 {
-    FIXME("(%p %p %p) stub\n", this, proc, data);
+    struct scheduled_task *task;
+    TP_CALLBACK_ENVIRON env;
+
+    TRACE("(%p %p %p)\n", this, proc, data);
+
+    memset(&env, 0, sizeof(env));
+    env.Version = 1;
+    env.Pool = ThreadScheduler_get_pool(this);
+
+    task = MSVCRT_operator_new(sizeof(*task));
+    task->scheduler = this;
+    task->proc = proc;
+    task->data = data;
+    ThreadScheduler_Reference(this);
+
+    if(!TrySubmitThreadpoolCallback(ThreadScheduler_task_proc, task, &env)) {
+        ThreadScheduler_Release(this);
+        MSVCRT_operator_delete(task);
+        throw_exception(EXCEPTION_SCHEDULER_RESOURCE_ALLOCATION_ERROR,
+                HRESULT_FROM_WIN32(GetLastError()), NULL);
+    }
+}
+
+DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask_loc, 16)
+void __thiscall ThreadScheduler_ScheduleTask_loc(ThreadScheduler *this,
+        void (__cdecl *proc)(void*), void* data, /*location*/void *placement)
+{
+    FIXME("(%p %p %p %p) placement ignored\n", this, proc, data, placement);
+    ThreadScheduler_ScheduleTask(this, proc, data);
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_IsAvailableLocation, 8)
@@ -778,6 +862,7 @@ static ThreadScheduler* ThreadScheduler_ctor(ThreadScheduler *this,
 
     this->shutdown_count = this->shutdown_size = 0;
     this->shutdown_events = NULL;
+    this->pool = NULL;
 
     InitializeCriticalSection(&this->cs);
     this->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": ThreadScheduler");
@@ -413,10 +413,34 @@ static void test_aligned(void)
     test_aligned_offset_realloc(256, 128, 64, 112);
 }
 
+static DWORD WINAPI sbheap_churn_thread(void *arg)
+{
+    BYTE *blocks[64];
+    int i, j, errors = 0;
+
+    for (i = 0; i < 2000; i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(blocks); j++)
+        {
+            blocks[j] = malloc(16 + (j % 8) * 16);
+            if (!blocks[j]) return ++errors;
+            memset(blocks[j], j, 16);
+        }
+        for (j = 0; j < ARRAY_SIZE(blocks); j++)
+        {
+            if (blocks[j][0] != j || blocks[j][15] != j) errors++;
+            free(blocks[j]);
+        }
+    }
+    return errors;
+}
+
 static void test_sbheap(void)
 {
+    HANDLE threads[4];
+    DWORD start, errors;
     void *mem;
-    int threshold;
+    int threshold, i;
 
     if(sizeof(void*) == 8) {
         ok(!_set_sbh_threshold(0), "_set_sbh_threshold succeeded\n");
@@ -449,6 +473,38 @@ static void test_sbheap(void)
     ok(mem != NULL, "realloc failed\n");
     ok(!((UINT_PTR)mem & 0xf), "incorrect alignment (%p)\n", mem);
 
+    memset(mem, 0xcc, 10);
+    mem = realloc(mem, 2000);
+    ok(mem != NULL, "realloc failed\n");
+    ok(((BYTE*)mem)[0] == 0xcc && ((BYTE*)mem)[9] == 0xcc, "data not preserved\n");
+    free(mem);
+
+    mem = malloc(10);
+    ok(mem != NULL, "malloc failed\n");
+    memset(mem, 0xcc, 10);
+    free(mem);
+    mem = calloc(1, 10);
+    ok(mem != NULL, "calloc failed\n");
+    ok(!((BYTE*)mem)[0] && !((BYTE*)mem)[9], "memory not zeroed\n");
+    free(mem);
+
+    start = GetTickCount();
+    for (i = 0; i < ARRAY_SIZE(threads); i++)
+    {
+        threads[i] = CreateThread(NULL, 0, sbheap_churn_thread, NULL, 0, NULL);
+        ok(threads[i] != NULL, "CreateThread failed\n");
+    }
+    for (i = 0; i < ARRAY_SIZE(threads); i++)
+    {
+        ok(!WaitForSingleObject(threads[i], 10000), "wait failed\n");
+        ok(GetExitCodeThread(threads[i], &errors) && !errors, "got %u errors\n", errors);
+        CloseHandle(threads[i]);
+    }
+    trace("small blocks churn took %u ms\n", GetTickCount() - start);
+
+    mem = malloc(10);
+    ok(mem != NULL, "malloc failed\n");
+
     ok(_set_sbh_threshold(0), "_set_sbh_threshold failed\n");
     threshold = _get_sbh_threshold();
     ok(threshold == 0, "threshold = %d\n", threshold);
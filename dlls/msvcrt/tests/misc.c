@@ -43,6 +43,7 @@ static void (__cdecl *p_qsort_s)(void*, size_t, size_t,
         int (__cdecl*)(void*, const void*, const void*), void*);
 static double (__cdecl *p_atan)(double);
 static double (__cdecl *p_exp)(double);
+static double (__cdecl *p_pow)(double, double);
 static double (__cdecl *p_tanh)(double);
 static void *(__cdecl *p_lfind_s)(const void*, const void*, unsigned int*,
         size_t, int (__cdecl *)(void*, const void*, const void*), void*);
@@ -62,6 +63,7 @@ static void init(void)
     p_qsort_s = (void *)GetProcAddress(hmod, "qsort_s");
     p_atan = (void *)GetProcAddress(hmod, "atan");
     p_exp = (void *)GetProcAddress(hmod, "exp");
+    p_pow = (void *)GetProcAddress(hmod, "pow");
     p_tanh = (void *)GetProcAddress(hmod, "tanh");
     p_lfind_s = (void *)GetProcAddress(hmod, "_lfind_s");
 }
@@ -523,6 +525,16 @@ static void test_math_functions(void)
     errno = 0xdeadbeef;
     p_exp(INFINITY);
     ok(errno == 0xdeadbeef, "errno = %d\n", errno);
+
+    errno = 0xdeadbeef;
+    ret = p_pow(-3.0, 2.0);
+    ok(ret == 9.0, "ret = %lf\n", ret);
+    ok(errno == 0xdeadbeef, "errno = %d\n", errno);
+
+    errno = 0xdeadbeef;
+    ret = p_pow(1e200, 2.0);
+    ok(ret == INFINITY, "ret = %lf\n", ret);
+    ok(errno == ERANGE, "errno = %d\n", errno);
 }
 
 static void __cdecl test_thread_func(void *end_thread_type)
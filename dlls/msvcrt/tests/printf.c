@@ -189,6 +189,9 @@ static void test_sprintf( void )
         { "%ws", "wide", 0, PTR_ARG, 0, 0, 0, L"wide" },
         { "%-10ws", "wide      ", 0, PTR_ARG, 0, 0, 0, L"wide" },
         { "%10ws", "      wide", 0, PTR_ARG, 0, 0, 0, L"wide" },
+        { "%40ws", "                                    wide", 0, PTR_ARG, 0, 0, 0, L"wide" },
+        { "%-40s", "foo                                     ", 0, PTR_ARG, 0, 0, 0, "foo" },
+        { "%040d", "-000000000000000000000000000000000000100", 0, INT_ARG, -100 },
         { "%#+ -03whlls", "wide", 0, PTR_ARG, 0, 0, 0, L"wide" },
         { "%w0s", "0s", 0, PTR_ARG, 0, 0, 0, L"wide" },
         { "%w-s", "-s", 0, PTR_ARG, 0, 0, 0, L"wide" },
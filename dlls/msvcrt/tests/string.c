@@ -4310,6 +4310,10 @@ START_TEST(string)
     pmemcpy(mem+5, mem,nLen+1);
     ok(pmemcmp(mem+5,xilstring, nLen) == 0,
        "Got result %s\n",mem+5);
+    strcpy(mem,xilstring);
+    pmemcpy(mem, mem+2, nLen-1);
+    ok(pmemcmp(mem,xilstring+2, nLen-1) == 0,
+       "Got result %s\n",mem);
 
     /* run tolower tests first */
     test_tolower();
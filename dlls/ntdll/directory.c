@@ -1495,6 +1495,8 @@ static BOOL append_entry( struct dir_data *data, const char *long_name,
  *           get_dir_data_entry
  *
  * Return a directory entry from the cached data.
+ * The attributes are retrieved one entry at a time as the entries are
+ * returned; FileNamesInformation only needs to know that the entry exists.
  */
 static NTSTATUS get_dir_data_entry( struct dir_data *dir_data, void *info_ptr, IO_STATUS_BLOCK *io,
                                     ULONG max_length, FILE_INFORMATION_CLASS class,
@@ -1504,8 +1506,17 @@ static NTSTATUS get_dir_data_entry( struct dir_data *dir_data, void *info_ptr, I
     union file_directory_info *info;
     struct stat st;
     ULONG name_len, start, dir_size, attributes;
+    int ret;
 
-    if (get_file_info( names->unix_name, &st, &attributes ) == -1)
+    if (class == FileNamesInformation)
+    {
+        /* only the name is returned, skip the symlink, mount point and xattr lookups */
+        ret = lstat( names->unix_name, &st );
+        if (!ret && S_ISLNK( st.st_mode )) stat( names->unix_name, &st );
+    }
+    else ret = get_file_info( names->unix_name, &st, &attributes );
+
+    if (ret == -1)
     {
         TRACE( "file no longer exists %s\n", names->unix_name );
         return STATUS_SUCCESS;
@@ -2023,6 +2034,167 @@ NTSTATUS WINAPI DECLSPEC_HOTPATCH NtQueryDirectoryFile( HANDLE handle, HANDLE ev
 }
 
 
+/* cache of directory contents for case-insensitive lookups */
+
+#define MAX_DIR_LOOKUP_CACHE 16
+
+struct dir_lookup_cache
+{
+    struct list           entry;       /* entry in dir_lookup_list */
+    struct file_identity  id;          /* directory identity */
+    time_t                mtime;       /* directory modification time when it was read */
+    long                  mtime_nsec;
+    unsigned int          hash_size;   /* size of the hash table, a power of 2 */
+    unsigned int         *hash;        /* hash table of indices + 1 into data->names */
+    struct dir_data      *data;        /* directory names */
+};
+
+static struct list dir_lookup_list = LIST_INIT( dir_lookup_list );
+static unsigned int dir_lookup_count;
+
+static inline long get_mtime_nsec( const struct stat *st )
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    return st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    return st->st_mtimespec.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+static ULONG hash_lookup_name( const WCHAR *name, unsigned int len )
+{
+    ULONG hash = 0;
+    while (len--) hash = hash * 65599 + towupper( *name++ );
+    return hash;
+}
+
+static void free_dir_lookup_cache( struct dir_lookup_cache *cache )
+{
+    list_remove( &cache->entry );
+    dir_lookup_count--;
+    free_dir_data( cache->data );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->hash );
+    RtlFreeHeap( GetProcessHeap(), 0, cache );
+}
+
+/***********************************************************************
+ *           create_dir_lookup_cache
+ *
+ * Read the contents of a directory and hash them by case-folded name.
+ * dir_section must be held by caller.
+ */
+static struct dir_lookup_cache *create_dir_lookup_cache( const char *unix_name, const struct stat *st )
+{
+    static const WCHAR empty[1];
+    WCHAR buffer[MAX_DIR_ENTRY_LEN + 1];
+    struct dir_lookup_cache *cache;
+    struct dirent *de;
+    unsigned int i, pos;
+    DIR *dir;
+    int ret;
+
+    if (!(cache = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cache) ))) return NULL;
+    if (!(cache->data = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cache->data) )))
+        goto error;
+    if (!(dir = opendir( unix_name ))) goto error;
+    while ((de = readdir( dir )))
+    {
+        ret = ntdll_umbstowcs( de->d_name, strlen(de->d_name), buffer, MAX_DIR_ENTRY_LEN );
+        buffer[ret] = 0;
+        if (!add_dir_data_names( cache->data, buffer, empty, de->d_name ))
+        {
+            closedir( dir );
+            goto error;
+        }
+    }
+    closedir( dir );
+
+    for (cache->hash_size = 16; cache->hash_size < 2 * cache->data->count; cache->hash_size *= 2) ;
+    if (!(cache->hash = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                         cache->hash_size * sizeof(*cache->hash) ))) goto error;
+    for (i = 0; i < cache->data->count; i++)
+    {
+        const WCHAR *name = cache->data->names[i].long_name;
+        pos = hash_lookup_name( name, wcslen(name) ) & (cache->hash_size - 1);
+        while (cache->hash[pos]) pos = (pos + 1) & (cache->hash_size - 1);
+        cache->hash[pos] = i + 1;
+    }
+
+    cache->id.dev     = st->st_dev;
+    cache->id.ino     = st->st_ino;
+    cache->mtime      = st->st_mtime;
+    cache->mtime_nsec = get_mtime_nsec( st );
+    list_add_head( &dir_lookup_list, &cache->entry );
+    if (++dir_lookup_count > MAX_DIR_LOOKUP_CACHE)
+        free_dir_lookup_cache( LIST_ENTRY( list_tail( &dir_lookup_list ), struct dir_lookup_cache, entry ));
+    return cache;
+
+error:
+    free_dir_data( cache->data );
+    RtlFreeHeap( GetProcessHeap(), 0, cache );
+    return NULL;
+}
+
+/***********************************************************************
+ *           lookup_dir_cache
+ *
+ * Look for a file name in the cached contents of a directory, reading them
+ * if necessary. On success the Unix name is copied into 'unix_name'.
+ * Returns STATUS_NOT_SUPPORTED if the directory cannot be cached.
+ */
+static NTSTATUS lookup_dir_cache( const char *dir_name, const WCHAR *name, int length, char *unix_name )
+{
+    struct dir_lookup_cache *cache;
+    struct stat st;
+    unsigned int pos, idx;
+    NTSTATUS status = STATUS_OBJECT_PATH_NOT_FOUND;
+
+    /* the casing table isn't loaded yet early in process init */
+    if (!casemap_loaded) return STATUS_NOT_SUPPORTED;
+    if (stat( dir_name, &st ) == -1) return STATUS_NOT_SUPPORTED;
+
+    RtlEnterCriticalSection( &dir_section );
+
+    LIST_FOR_EACH_ENTRY( cache, &dir_lookup_list, struct dir_lookup_cache, entry )
+    {
+        if (!is_same_file( &cache->id, &st )) continue;
+        if (cache->mtime == st.st_mtime && cache->mtime_nsec == get_mtime_nsec( &st ))
+        {
+            list_remove( &cache->entry );
+            list_add_head( &dir_lookup_list, &cache->entry );
+            goto found;
+        }
+        free_dir_lookup_cache( cache );
+        break;
+    }
+
+    /* don't cache a directory that may still change within the current mtime granularity */
+    if (st.st_mtime >= time( NULL ) - 1 || !(cache = create_dir_lookup_cache( dir_name, &st )))
+    {
+        RtlLeaveCriticalSection( &dir_section );
+        return STATUS_NOT_SUPPORTED;
+    }
+
+found:
+    pos = hash_lookup_name( name, length ) & (cache->hash_size - 1);
+    while ((idx = cache->hash[pos]))
+    {
+        const struct dir_data_names *names = &cache->data->names[idx - 1];
+        if (!RtlCompareUnicodeStrings( names->long_name, wcslen(names->long_name), name, length, TRUE ))
+        {
+            strcpy( unix_name, names->unix_name );
+            status = STATUS_SUCCESS;
+            break;
+        }
+        pos = (pos + 1) & (cache->hash_size - 1);
+    }
+    RtlLeaveCriticalSection( &dir_section );
+    return status;
+}
+
+
 /***********************************************************************
  *           find_file_in_dir
  *
@@ -2130,6 +2302,19 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
     }
 #endif /* VFAT_IOCTL_READDIR_BOTH */
 
+    /* generated short names always have a '~' in fifth position, anything else can only
+     * match a long name so the directory cache has the complete answer */
+    if (length < 8 || name[4] != '~')
+    {
+        NTSTATUS status = lookup_dir_cache( unix_name, name, length, unix_name + pos );
+        if (status != STATUS_NOT_SUPPORTED)
+        {
+            if (status) goto not_found;
+            unix_name[pos - 1] = '/';
+            goto success;
+        }
+    }
+
     if (!(dir = opendir( unix_name )))
     {
         if (errno == ENOENT) return STATUS_OBJECT_PATH_NOT_FOUND;
@@ -111,6 +111,7 @@ struct norm_table
 };
 
 LCID user_lcid = 0, system_lcid = 0;
+BOOL casemap_loaded = FALSE;  /* set once the NLS casing tables are available */
 
 static LANGID user_ui_language, system_ui_language;
 static NLSTABLEINFO nls_info;
@@ -1216,6 +1217,7 @@ void WINAPI RtlResetRtlTranslations( const NLSTABLEINFO *info )
     NlsMbCodePageTag    = info->AnsiTableInfo.DBCSCodePage;
     NlsMbOemCodePageTag = info->OemTableInfo.DBCSCodePage;
     nls_info = *info;
+    casemap_loaded = nls_info.UpperCaseTable != NULL;
 }
 
 
@@ -1761,6 +1763,38 @@ found:
 }
 
 
+/* helper for the utf8 conversions: length of the leading run of 7-bit ASCII chars */
+static inline unsigned int ascii_lengthA( const char *str, unsigned int len )
+{
+    unsigned int i = 0;
+    UINT64 val;
+
+    /* check 8 chars at a time */
+    for ( ; i + sizeof(val) <= len; i += sizeof(val))
+    {
+        memcpy( &val, str + i, sizeof(val) );
+        if (val & 0x8080808080808080ull) break;
+    }
+    while (i < len && !(str[i] & 0x80)) i++;
+    return i;
+}
+
+/* helper for the utf8 conversions: length of the leading run of 7-bit ASCII chars */
+static inline unsigned int ascii_lengthW( const WCHAR *str, unsigned int len )
+{
+    unsigned int i = 0;
+    UINT64 val;
+
+    /* check 4 chars at a time */
+    for ( ; i + sizeof(val) / sizeof(WCHAR) <= len; i += sizeof(val) / sizeof(WCHAR))
+    {
+        memcpy( &val, str + i, sizeof(val) );
+        if (val & 0xff80ff80ff80ff80ull) break;
+    }
+    while (i < len && str[i] < 0x80) i++;
+    return i;
+}
+
 /* helper for the various utf8 mbstowcs functions */
 static unsigned int decode_utf8_char( unsigned char ch, const char **str, const char *strend )
 {
@@ -1833,8 +1867,13 @@ NTSTATUS WINAPI RtlUTF8ToUnicodeN( WCHAR *dst, DWORD dstlen, DWORD *reslen, cons
     {
         for (len = 0; src < srcend; len++)
         {
-            unsigned char ch = *src++;
-            if (ch < 0x80) continue;
+            unsigned char ch;
+            unsigned int count = ascii_lengthA( src, srcend - src );
+
+            len += count;
+            src += count;
+            if (src == srcend) break;
+            ch = *src++;
             if ((res = decode_utf8_char( ch, &src, srcend )) > 0x10ffff)
                 status = STATUS_SOME_NOT_MAPPED;
             else
@@ -1846,12 +1885,16 @@ NTSTATUS WINAPI RtlUTF8ToUnicodeN( WCHAR *dst, DWORD dstlen, DWORD *reslen, cons
 
     while ((dst < dstend) && (src < srcend))
     {
-        unsigned char ch = *src++;
-        if (ch < 0x80)  /* special fast case for 7-bit ASCII */
-        {
-            *dst++ = ch;
-            continue;
-        }
+        unsigned char ch;
+        unsigned int i, count = ascii_lengthA( src, min( srcend - src, dstend - dst ));
+
+        /* special fast case for 7-bit ASCII */
+        for (i = 0; i < count; i++) dst[i] = (unsigned char)src[i];
+        dst += count;
+        src += count;
+        if (dst == dstend || src == srcend) break;
+
+        ch = *src++;
         if ((res = decode_utf8_char( ch, &src, srcend )) <= 0xffff)
         {
             *dst++ = res;
@@ -1894,6 +1937,12 @@ NTSTATUS WINAPI RtlUnicodeToUTF8N( char *dst, DWORD dstlen, DWORD *reslen, const
     {
         for (len = 0; srclen; srclen--, src++)
         {
+            unsigned int count = ascii_lengthW( src, srclen );
+
+            len += count;
+            src += count;
+            srclen -= count;
+            if (!srclen) break;
             if (*src < 0x80) len++;  /* 0x00-0x7f: 1 byte */
             else if (*src < 0x800) len += 2;  /* 0x80-0x7ff: 2 bytes */
             else
@@ -1918,8 +1967,16 @@ NTSTATUS WINAPI RtlUnicodeToUTF8N( char *dst, DWORD dstlen, DWORD *reslen, const
 
     for (end = dst + dstlen; srclen; srclen--, src++)
     {
-        WCHAR ch = *src;
+        WCHAR ch;
+        unsigned int i, count = ascii_lengthW( src, min( srclen, end - dst ));
+
+        for (i = 0; i < count; i++) dst[i] = src[i];
+        dst += count;
+        src += count;
+        srclen -= count;
+        if (!srclen) break;
 
+        ch = *src;
         if (ch < 0x80)  /* 0x00-0x7f: 1 byte */
         {
             if (dst > end - 1) break;
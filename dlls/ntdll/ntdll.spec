@@ -153,6 +153,7 @@
 @ stdcall NtClose(long)
 @ stub NtCloseObjectAuditAlarm
 # @ stub NtCompactKeys
+@ stdcall NtCompareObjects(long long)
 # @ stub NtCompareTokens
 @ stdcall NtCompleteConnectPort(ptr)
 # @ stub NtCompressKey
@@ -1127,6 +1128,7 @@
 @ stdcall -private ZwClose(long) NtClose
 @ stub ZwCloseObjectAuditAlarm
 # @ stub ZwCompactKeys
+@ stdcall -private ZwCompareObjects(long long) NtCompareObjects
 # @ stub ZwCompareTokens
 @ stdcall -private ZwCompleteConnectPort(ptr) NtCompleteConnectPort
 # @ stub ZwCompressKey
@@ -449,12 +449,18 @@ NTSTATUS close_handle( HANDLE handle )
     if (do_esync())
         esync_close( handle );
 
-    SERVER_START_REQ( close_handle )
+    /* a handle known to be closed doesn't need a server round trip */
+    if (server_get_shared_handle( handle, NULL, NULL ) == STATUS_INVALID_HANDLE)
+        ret = STATUS_INVALID_HANDLE;
+    else
     {
-        req->handle = wine_server_obj_handle( handle );
-        ret = wine_server_call( req );
+        SERVER_START_REQ( close_handle )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            ret = wine_server_call( req );
+        }
+        SERVER_END_REQ;
     }
-    SERVER_END_REQ;
     if (fd != -1) close( fd );
 
     if (ret == STATUS_INVALID_HANDLE && handle && NtCurrentTeb()->Peb->BeingDebugged)
@@ -495,6 +501,40 @@ NTSTATUS WINAPI NtClose( HANDLE Handle )
     return close_handle( Handle );
 }
 
+/**************************************************************************
+ *                 NtCompareObjects			[NTDLL.@]
+ *
+ * Check whether two handles refer to the same kernel object.
+ *
+ * PARAMS
+ *  first  [I] first object handle
+ *  second [I] second object handle
+ *
+ * RETURNS
+ *  Success: STATUS_SUCCESS if both handles refer to the same object.
+ *  Failure: STATUS_NOT_SAME_OBJECT, or another NTSTATUS error code.
+ */
+NTSTATUS WINAPI NtCompareObjects( HANDLE first, HANDLE second )
+{
+    client_ptr_t first_obj, second_obj;
+    NTSTATUS ret;
+
+    TRACE( "%p %p\n", first, second );
+
+    if (!server_get_shared_handle( first, &first_obj, NULL ) &&
+        !server_get_shared_handle( second, &second_obj, NULL ))
+        return first_obj == second_obj ? STATUS_SUCCESS : STATUS_NOT_SAME_OBJECT;
+
+    SERVER_START_REQ( compare_objects )
+    {
+        req->first  = wine_server_obj_handle( first );
+        req->second = wine_server_obj_handle( second );
+        ret = wine_server_call( req );
+    }
+    SERVER_END_REQ;
+    return ret;
+}
+
 /*
  *	Directory functions
  */
@@ -461,6 +461,45 @@ void WINAPI RtlReleaseRelativeName(RTL_RELATIVE_NAME *relative)
 {
 }
 
+/******************************************************************
+ *		get_path_entry_len
+ *
+ * Helper for RtlDosSearchPath_U. Get the length of a search path entry,
+ * ignoring a trailing backslash since one is appended anyway. The backslash
+ * of a drive root is kept, "C:\" and "C:" are different directories.
+ */
+static ULONG get_path_entry_len( LPCWSTR entry, LPCWSTR *next )
+{
+    ULONG len;
+
+    for (len = 0; entry[len] && entry[len] != ';'; len++);
+    *next = entry[len] ? entry + len + 1 : entry + len;
+    if (len > 1 && entry[len - 1] == '\\' && !(len == 3 && entry[1] == ':')) len--;
+    return len;
+}
+
+
+/******************************************************************
+ *		is_duplicate_path_entry
+ *
+ * Helper for RtlDosSearchPath_U. Check if a search path entry already
+ * appears earlier in the list; the search path usually contains the
+ * system directories twice, and there is no point in probing them again.
+ */
+static BOOL is_duplicate_path_entry( LPCWSTR paths, LPCWSTR entry )
+{
+    LPCWSTR next;
+    ULONG len = get_path_entry_len( entry, &next );
+
+    while (paths < entry)
+    {
+        if (get_path_entry_len( paths, &next ) == len && !wcsnicmp( paths, entry, len )) return TRUE;
+        paths = next;
+    }
+    return FALSE;
+}
+
+
 /******************************************************************
  *		RtlDosSearchPath_U
  *
@@ -482,6 +521,7 @@ ULONG WINAPI RtlDosSearchPath_U(LPCWSTR paths, LPCWSTR search, LPCWSTR ext,
     if (type == RELATIVE_PATH)
     {
         ULONG allocated = 0, needed, filelen;
+        LPCWSTR start = paths;
         WCHAR *name = NULL;
 
         filelen = 1 /* for \ */ + wcslen(search) + 1 /* \0 */;
@@ -495,6 +535,11 @@ ULONG WINAPI RtlDosSearchPath_U(LPCWSTR paths, LPCWSTR search, LPCWSTR ext,
             LPCWSTR ptr;
 
             for (needed = 0, ptr = paths; *ptr != 0 && *ptr++ != ';'; needed++);
+            if (is_duplicate_path_entry( start, paths ))
+            {
+                paths = ptr;
+                continue;
+            }
             if (needed + filelen > allocated)
             {
                 if (!name) name = RtlAllocateHeap(GetProcessHeap(), 0,
@@ -142,6 +142,7 @@ timeout_t server_start_time = 0;  /* time of server startup */
 sigset_t server_block_set;  /* signals to block during server calls */
 static int fd_socket = -1;  /* socket to exchange file descriptors with the server */
 static pid_t server_pid;
+static shmprocess_t *shmprocess;  /* process shared memory block */
 
 RTL_CRITICAL_SECTION fd_cache_section;
 static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
@@ -893,7 +894,7 @@ C_ASSERT( sizeof(union fd_cache_entry) == sizeof(LONG64) );
 #define FD_CACHE_BLOCK_SIZE  (65536 / sizeof(union fd_cache_entry))
 #define FD_CACHE_ENTRIES     128
 
-static union fd_cache_entry *fd_cache[FD_CACHE_ENTRIES];
+static union fd_cache_entry * volatile fd_cache[FD_CACHE_ENTRIES];
 static union fd_cache_entry fd_cache_initial_block[FD_CACHE_BLOCK_SIZE];
 
 static inline unsigned int handle_to_index( HANDLE handle, unsigned int *entry )
@@ -903,11 +904,23 @@ static inline unsigned int handle_to_index( HANDLE handle, unsigned int *entry )
     return idx % FD_CACHE_BLOCK_SIZE;
 }
 
+/* read an entry without taking the cache line for writing; aligned 64-bit
+ * loads are atomic on 64-bit platforms, elsewhere we need a locked cmpxchg */
+static inline LONG64 read_fd_cache_entry( union fd_cache_entry *cache )
+{
+#ifdef _WIN64
+    return *(volatile LONG64 *)&cache->data;
+#else
+    return interlocked_cmpxchg64( &cache->data, 0, 0 );
+#endif
+}
+
 
 /***********************************************************************
  *           add_fd_to_cache
  *
- * Caller must hold fd_cache_section.
+ * Caller must hold fd_cache_section. Fails if the slot is already in use,
+ * in which case the caller keeps ownership of the fd.
  */
 static BOOL add_fd_to_cache( HANDLE handle, int fd, enum server_fd_type type,
                             unsigned int access, unsigned int options )
@@ -938,8 +951,11 @@ static BOOL add_fd_to_cache( HANDLE handle, int fd, enum server_fd_type type,
     cache.s.type = type;
     cache.s.access = access;
     cache.s.options = options;
-    cache.data = interlocked_xchg64( &fd_cache[entry][idx].data, cache.data );
-    assert( !cache.s.fd );
+    if (interlocked_cmpxchg64( &fd_cache[entry][idx].data, cache.data, 0 ))
+    {
+        WARN( "cache entry for %p already in use\n", handle );
+        return FALSE;
+    }
     return TRUE;
 }
 
@@ -955,7 +971,7 @@ static inline NTSTATUS get_cached_fd( HANDLE handle, int *fd, enum server_fd_typ
 
     if (entry >= FD_CACHE_ENTRIES || !fd_cache[entry]) return STATUS_INVALID_HANDLE;
 
-    cache.data = interlocked_cmpxchg64( &fd_cache[entry][idx].data, 0, 0 );
+    cache.data = read_fd_cache_entry( &fd_cache[entry][idx] );
     if (!cache.data) return STATUS_INVALID_HANDLE;
 
     /* if fd type is invalid, fd stores an error value */
@@ -1003,7 +1019,7 @@ void CDECL wine_server_close_fds_by_type( enum server_fd_type type )
         if (!fd_cache[entry]) continue;
         for (idx = 0; idx < FD_CACHE_BLOCK_SIZE; idx++)
         {
-            cache.data = interlocked_cmpxchg64( &fd_cache[entry][idx].data, 0, 0 );
+            cache.data = read_fd_cache_entry( &fd_cache[entry][idx] );
             if (cache.s.type != type || cache.s.fd == 0) continue;
             if (interlocked_cmpxchg64( &fd_cache[entry][idx].data, 0, cache.data ) != cache.data) continue;
             close( cache.s.fd - 1 );
@@ -1078,7 +1094,7 @@ done:
  *
  * Receive a file descriptor to a server shared memory block.
  */
-static int server_get_shared_memory_fd( HANDLE thread, int *unix_fd )
+static int server_get_shared_memory_fd( HANDLE thread, BOOL process, int *unix_fd )
 {
     obj_handle_t dummy;
     sigset_t sigset;
@@ -1088,7 +1104,8 @@ static int server_get_shared_memory_fd( HANDLE thread, int *unix_fd )
 
     SERVER_START_REQ( get_shared_memory )
     {
-        req->tid = HandleToULong(thread);
+        req->tid     = HandleToULong(thread);
+        req->process = process;
         if (!(ret = wine_server_call( req )))
         {
             *unix_fd = receive_fd( &dummy );
@@ -1137,7 +1154,7 @@ void *server_get_shared_memory( HANDLE thread )
     if (!thread && shmglobal != (void *)-1)
         return shmglobal;
 
-    if (!server_get_shared_memory_fd( thread, &fd ))
+    if (!server_get_shared_memory_fd( thread, FALSE, &fd ))
     {
         SIZE_T size = thread ? sizeof(shmlocal_t) : sizeof(shmglobal_t);
         virtual_map_shared_memory( fd, &mem, 0, &size, PAGE_READONLY );
@@ -1154,6 +1171,68 @@ void *server_get_shared_memory( HANDLE thread )
 }
 
 
+/***********************************************************************
+ *           server_init_process_shared_memory
+ *
+ * Map the process shared memory block mirroring the handle table.
+ */
+static void server_init_process_shared_memory(void)
+{
+    void *mem = NULL;
+    int fd = -1;
+
+    if (!experimental_SHARED_MEMORY())
+        return;
+
+    if (!server_get_shared_memory_fd( 0, TRUE, &fd ))
+    {
+        SIZE_T size = sizeof(shmprocess_t);
+        virtual_map_shared_memory( fd, &mem, 0, &size, PAGE_READONLY );
+        close( fd );
+    }
+    shmprocess = mem;
+}
+
+
+/***********************************************************************
+ *           server_get_shared_handle
+ *
+ * Look up a handle in the process shared memory block.
+ * Returns STATUS_INVALID_HANDLE if the handle is known to be closed, and
+ * STATUS_NOT_SUPPORTED if the server has to be asked.
+ */
+NTSTATUS server_get_shared_handle( HANDLE handle, client_ptr_t *object, unsigned int *access )
+{
+    const volatile shm_handle_t *entry;
+    obj_handle_t h = wine_server_obj_handle( handle );
+    unsigned int seq, tries, index = (h >> 2) - 1;
+    client_ptr_t obj;
+    unsigned int acc;
+
+    if (!shmprocess) return STATUS_NOT_SUPPORTED;
+    if ((ULONG_PTR)handle != h || !h || (h & 3)) return STATUS_NOT_SUPPORTED;
+    if (index >= SHM_HANDLE_COUNT) return STATUS_NOT_SUPPORTED;  /* also covers global handles */
+
+    entry = &shmprocess->handles[index];
+    for (tries = 0; tries < 16; tries++)
+    {
+        seq = entry->seq;
+        if (seq & 1) continue;
+        __sync_synchronize();
+        obj = entry->object;
+        acc = entry->access;
+        __sync_synchronize();
+        if (entry->seq != seq) continue;
+
+        if (!obj) return STATUS_INVALID_HANDLE;
+        if (object) *object = obj;
+        if (access) *access = acc;
+        return STATUS_SUCCESS;
+    }
+    return STATUS_NOT_SUPPORTED;
+}
+
+
 /***********************************************************************
  *           wine_server_fd_to_handle   (NTDLL.@)
  *
@@ -1649,6 +1728,8 @@ void server_init_process_done(void)
      * something is very wrong... */
     signal_init_process();
 
+    server_init_process_shared_memory();
+
     /* Signal the parent process to continue */
     SERVER_START_REQ( init_process_done )
     {
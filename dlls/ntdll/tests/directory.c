@@ -827,6 +827,64 @@ done:
     pRtlFreeUnicodeString(&ntdirname);
 }
 
+static void set_dir_time(const char *testdir, DWORD days)
+{
+    FILETIME ft = { 0, 0 };
+    HANDLE h;
+    BOOL ret;
+
+    /* move the directory modification time into the past so that its contents are cached */
+    h = CreateFileA(testdir, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                    OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, 0);
+    ok(h != INVALID_HANDLE_VALUE, "failed to open dir '%s', error %d\n", testdir, GetLastError());
+    ft.dwHighDateTime = 0x01c00000 + days * 0xc9;
+    ret = SetFileTime(h, NULL, NULL, &ft);
+    ok(ret, "SetFileTime failed, error %d\n", GetLastError());
+    CloseHandle(h);
+}
+
+static void test_case_insensitive_open(void)
+{
+    char testdir[MAX_PATH], buf[MAX_PATH + 16];
+    HANDLE h;
+    BOOL ret;
+
+    ok(GetTempPathA(MAX_PATH, testdir), "couldn't get temp dir\n");
+    strcat(testdir, "case2.tmp");
+    tear_down_case_test(testdir);
+    set_up_case_test(testdir);
+    set_dir_time(testdir, 1);
+
+    sprintf(buf, "%s\\%s", testdir, "TEST");
+    h = CreateFileA(buf, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, 0);
+    ok(h != INVALID_HANDLE_VALUE, "failed to open '%s', error %d\n", buf, GetLastError());
+    CloseHandle(h);
+    sprintf(buf, "%s\\%s", testdir, "test");
+    h = CreateFileA(buf, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, 0);
+    ok(h != INVALID_HANDLE_VALUE, "failed to open '%s', error %d\n", buf, GetLastError());
+    CloseHandle(h);
+
+    sprintf(buf, "%s\\%s", testdir, "NewFile");
+    h = CreateFileA(buf, GENERIC_WRITE, 0, NULL, CREATE_NEW, 0, 0);
+    ok(h != INVALID_HANDLE_VALUE, "failed to create '%s', error %d\n", buf, GetLastError());
+    CloseHandle(h);
+    set_dir_time(testdir, 2);
+
+    sprintf(buf, "%s\\%s", testdir, "NEWFILE");
+    h = CreateFileA(buf, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, 0);
+    ok(h != INVALID_HANDLE_VALUE, "failed to open '%s', error %d\n", buf, GetLastError());
+    CloseHandle(h);
+    ret = DeleteFileA(buf);
+    ok(ret, "failed to delete '%s', error %d\n", buf, GetLastError());
+    set_dir_time(testdir, 3);
+
+    h = CreateFileA(buf, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, 0);
+    ok(h == INVALID_HANDLE_VALUE, "'%s' should not exist\n", buf);
+    ok(GetLastError() == ERROR_FILE_NOT_FOUND, "got error %d\n", GetLastError());
+
+    tear_down_case_test(testdir);
+}
+
 static void test_redirection(void)
 {
     ULONG old, cur;
@@ -905,5 +963,6 @@ START_TEST(directory)
     test_directory_sort( sysdir );
     test_NtQueryDirectoryFile();
     test_NtQueryDirectoryFile_case();
+    test_case_insensitive_open();
     test_redirection();
 }
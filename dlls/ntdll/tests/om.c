@@ -77,6 +77,7 @@ static NTSTATUS (WINAPI *pRtlWaitOnAddress)( const void *, const void *, SIZE_T,
 static void     (WINAPI *pRtlWakeAddressAll)( const void * );
 static void     (WINAPI *pRtlWakeAddressSingle)( const void * );
 static NTSTATUS (WINAPI *pNtQuerySystemInformation)(SYSTEM_INFORMATION_CLASS, PVOID, ULONG, PULONG);
+static NTSTATUS (WINAPI *pNtCompareObjects)(HANDLE, HANDLE);
 
 #define KEYEDEVENT_WAIT       0x0001
 #define KEYEDEVENT_WAKE       0x0002
@@ -2266,6 +2267,92 @@ static void test_wait_on_address(void)
     ok(address == 0, "got %s\n", wine_dbgstr_longlong(address));
 }
 
+static void test_compare_objects(void)
+{
+    HANDLE event, event2, dup;
+    NTSTATUS status;
+
+    if (!pNtCompareObjects)
+    {
+        win_skip("NtCompareObjects is not available\n");
+        return;
+    }
+
+    event = CreateEventA( NULL, FALSE, FALSE, NULL );
+    ok( event != NULL, "CreateEvent failed: %u\n", GetLastError() );
+    event2 = CreateEventA( NULL, FALSE, FALSE, NULL );
+    ok( event2 != NULL, "CreateEvent failed: %u\n", GetLastError() );
+    ok( DuplicateHandle( GetCurrentProcess(), event, GetCurrentProcess(), &dup,
+                         SYNCHRONIZE, FALSE, 0 ), "DuplicateHandle failed: %u\n", GetLastError() );
+
+    status = pNtCompareObjects( event, event );
+    ok( status == STATUS_SUCCESS, "got %#x\n", status );
+    status = pNtCompareObjects( event, dup );
+    ok( status == STATUS_SUCCESS, "got %#x\n", status );
+    status = pNtCompareObjects( dup, event2 );
+    ok( status == STATUS_NOT_SAME_OBJECT, "got %#x\n", status );
+    status = pNtCompareObjects( GetCurrentProcess(), GetCurrentProcess() );
+    ok( status == STATUS_SUCCESS, "got %#x\n", status );
+
+    pNtClose( event2 );
+    status = pNtCompareObjects( event, event2 );
+    ok( status == STATUS_INVALID_HANDLE, "got %#x\n", status );
+    status = pNtClose( event2 );
+    ok( status == STATUS_INVALID_HANDLE, "got %#x\n", status );
+
+    pNtClose( dup );
+    pNtClose( event );
+}
+
+static void test_many_names(void)
+{
+    static const unsigned int count = 4096;
+    HANDLE *events, handle;
+    DWORD start, create_time, open_time;
+    char name[64];
+    unsigned int i;
+
+    events = HeapAlloc( GetProcessHeap(), 0, count * sizeof(*events) );
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "wine_test_many_names_%u_%u", GetCurrentProcessId(), i );
+        SetLastError( 0xdeadbeef );
+        events[i] = CreateEventA( NULL, FALSE, FALSE, name );
+        ok( events[i] != NULL, "%u: CreateEvent failed: %u\n", i, GetLastError() );
+        ok( GetLastError() == ERROR_SUCCESS, "%u: got error %u\n", i, GetLastError() );
+    }
+    create_time = GetTickCount() - start;
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "wine_test_many_names_%u_%u", GetCurrentProcessId(), i );
+        handle = OpenEventA( EVENT_MODIFY_STATE, FALSE, name );
+        ok( handle != NULL, "%u: OpenEvent failed: %u\n", i, GetLastError() );
+        SetEvent( handle );
+        CloseHandle( handle );
+        ok( !WaitForSingleObject( events[i], 0 ), "%u: opened the wrong event\n", i );
+    }
+    open_time = GetTickCount() - start;
+    trace( "%u named events: create %u ms, open %u ms\n", count, create_time, open_time );
+
+    /* names are gone once the objects are destroyed */
+    for (i = 0; i < count; i += 2) CloseHandle( events[i] );
+    for (i = 0; i < count; i++)
+    {
+        sprintf( name, "wine_test_many_names_%u_%u", GetCurrentProcessId(), i );
+        handle = OpenEventA( SYNCHRONIZE, FALSE, name );
+        if (i % 2) ok( handle != NULL, "%u: OpenEvent failed: %u\n", i, GetLastError() );
+        else ok( !handle, "%u: OpenEvent succeeded\n", i );
+        if (handle) CloseHandle( handle );
+    }
+    for (i = 1; i < count; i += 2) CloseHandle( events[i] );
+
+    HeapFree( GetProcessHeap(), 0, events );
+}
+
 START_TEST(om)
 {
     HMODULE hntdll = GetModuleHandleA("ntdll.dll");
@@ -2326,6 +2413,7 @@ START_TEST(om)
     pRtlWakeAddressAll      =  (void *)GetProcAddress(hntdll, "RtlWakeAddressAll");
     pRtlWakeAddressSingle   =  (void *)GetProcAddress(hntdll, "RtlWakeAddressSingle");
     pNtQuerySystemInformation = (void *)GetProcAddress(hntdll, "NtQuerySystemInformation");
+    pNtCompareObjects       =  (void *)GetProcAddress(hntdll, "NtCompareObjects");
 
     test_case_sensitive();
     test_namespace_pipe();
@@ -2341,4 +2429,6 @@ START_TEST(om)
     test_keyed_events();
     test_null_device();
     test_wait_on_address();
+    test_compare_objects();
+    test_many_names();
 }
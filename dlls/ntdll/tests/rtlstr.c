@@ -2590,6 +2590,49 @@ static void test_RtlUTF8ToUnicodeN(void)
         ok(buffer[ret] == 0x5555,
            "(test %d): behind string: 0x%x\n", i, buffer[ret]);
     }
+
+    /* non-ASCII char at every position in a long ASCII run */
+    for (i = 0; i < 40; i++)
+    {
+        char utf8[48], utf8_out[48];
+        WCHAR expected[48];
+        unsigned int j;
+
+        for (j = 0; j < 41; j++) expected[j] = 'a' + j % 26;
+        expected[i] = 0xe9;
+        memcpy(utf8, "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz", i);
+        utf8[i] = 0xc3;
+        utf8[i + 1] = 0xa9;
+        for (j = i + 1; j < 41; j++) utf8[j + 1] = 'a' + j % 26;
+
+        bytes_out = 0x55555555;
+        status = pRtlUTF8ToUnicodeN(NULL, 0, &bytes_out, utf8, 42);
+        ok(status == STATUS_SUCCESS, "%u: status = 0x%x\n", i, status);
+        ok(bytes_out == 41 * sizeof(WCHAR), "%u: bytes_out = %u\n", i, bytes_out);
+
+        memset(buffer, 0x55, sizeof(buffer));
+        status = pRtlUTF8ToUnicodeN(buffer, sizeof(buffer), &bytes_out, utf8, 42);
+        ok(status == STATUS_SUCCESS, "%u: status = 0x%x\n", i, status);
+        ok(bytes_out == 41 * sizeof(WCHAR), "%u: bytes_out = %u\n", i, bytes_out);
+        ok(!memcmp(buffer, expected, 41 * sizeof(WCHAR)), "%u: got %s\n", i, wine_dbgstr_wn(buffer, 41));
+
+        memset(buffer, 0x55, sizeof(buffer));
+        status = pRtlUTF8ToUnicodeN(buffer, i * sizeof(WCHAR), &bytes_out, utf8, 42);
+        ok(status == STATUS_BUFFER_TOO_SMALL, "%u: status = 0x%x\n", i, status);
+        ok(bytes_out == i * sizeof(WCHAR), "%u: bytes_out = %u\n", i, bytes_out);
+        ok(buffer[i] == 0x5555, "%u: behind string: 0x%x\n", i, buffer[i]);
+
+        status = pRtlUnicodeToUTF8N(NULL, 0, &bytes_out, expected, 41 * sizeof(WCHAR));
+        ok(status == STATUS_SUCCESS, "%u: status = 0x%x\n", i, status);
+        ok(bytes_out == 42, "%u: bytes_out = %u\n", i, bytes_out);
+
+        memset(utf8_out, 0x55, sizeof(utf8_out));
+        status = pRtlUnicodeToUTF8N(utf8_out, sizeof(utf8_out), &bytes_out, expected, 41 * sizeof(WCHAR));
+        ok(status == STATUS_SUCCESS, "%u: status = 0x%x\n", i, status);
+        ok(bytes_out == 42, "%u: bytes_out = %u\n", i, bytes_out);
+        ok(!memcmp(utf8_out, utf8, 42), "%u: got %s\n", i, wine_dbgstr_an(utf8_out, bytes_out));
+        ok(utf8_out[42] == 0x55, "%u: behind string: 0x%x\n", i, utf8_out[42]);
+    }
 }
 
 START_TEST(rtlstr)
@@ -44,6 +44,16 @@
 #ifdef HAVE_SYS_SYSINFO_H
 # include <sys/sysinfo.h>
 #endif
+#ifdef HAVE_SYS_IOCTL_H
+# include <sys/ioctl.h>
+#endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
+#ifdef HAVE_LINUX_USERFAULTFD_H
+# include <linux/fs.h>
+# include <linux/userfaultfd.h>
+#endif
 #ifdef HAVE_VALGRIND_VALGRIND_H
 # include <valgrind/valgrind.h>
 #endif
@@ -86,6 +96,7 @@ struct file_view
 #define VPROT_WRITEWATCH 0x40
 /* per-mapping protection flags */
 #define VPROT_SYSTEM     0x0200  /* system view (underlying mmap not under our control) */
+#define VPROT_KERNEL_WRITEWATCH 0x0400  /* write watches tracked by the kernel */
 
 /* Conversion from VPROT_* to Win32 flags */
 static const BYTE VIRTUAL_Win32Flags[16] =
@@ -109,6 +120,7 @@ static const BYTE VIRTUAL_Win32Flags[16] =
 };
 
 static struct wine_rb_tree views_tree;
+static struct file_view *last_view;  /* last view found by VIRTUAL_FindView */
 
 static void *last_already_mapped;
 static size_t last_already_mapped_size;
@@ -443,17 +455,25 @@ static void VIRTUAL_Dump(void)
 static struct file_view *VIRTUAL_FindView( const void *addr, size_t size )
 {
     struct wine_rb_entry *ptr = views_tree.root;
+    struct file_view *view = last_view;
 
     if ((const char *)addr + size < (const char *)addr) return NULL; /* overflow */
 
+    /* repeated calls on the same range are common, check the last view found first */
+    if (view && view->base <= addr && (const char *)view->base + view->size > (const char *)addr)
+    {
+        if ((const char *)view->base + view->size < (const char *)addr + size) return NULL;  /* size too large */
+        return view;
+    }
+
     while (ptr)
     {
-        struct file_view *view = WINE_RB_ENTRY_VALUE( ptr, struct file_view, entry );
+        view = WINE_RB_ENTRY_VALUE( ptr, struct file_view, entry );
 
         if (view->base > addr) ptr = ptr->left;
         else if ((const char *)view->base + view->size <= (const char *)addr) ptr = ptr->right;
         else if ((const char *)view->base + view->size < (const char *)addr + size) break;  /* size too large */
-        else return view;
+        else return last_view = view;
     }
     return NULL;
 }
@@ -514,6 +534,18 @@ static inline BOOL is_write_watch_range( const void *addr, size_t size )
 }
 
 
+/***********************************************************************
+ *           get_kernel_write_watch_view
+ *
+ * Return the view of a write watch range tracked by the kernel.
+ */
+static inline struct file_view *get_kernel_write_watch_view( const void *addr, size_t size )
+{
+    struct file_view *view = VIRTUAL_FindView( addr, size );
+    return view && (view->protect & VPROT_KERNEL_WRITEWATCH) ? view : NULL;
+}
+
+
 /***********************************************************************
  *           is_system_range
  */
@@ -851,6 +883,7 @@ static void delete_view( struct file_view *view ) /* [in] View */
     wine_mmap_add_free_area(view->base, view->size);
     if (!(view->protect & VPROT_SYSTEM)) unmap_area( view->base, view->size );
     set_page_vprot( view->base, view->size, 0 );
+    if (last_view == view) last_view = NULL;
     wine_rb_remove( &views_tree, &view->entry );
     *(struct file_view **)view = next_free_view;
     next_free_view = view;
@@ -1092,6 +1125,149 @@ static NTSTATUS set_protection( struct file_view *view, void *base, SIZE_T size,
 }
 
 
+#if defined(HAVE_LINUX_USERFAULTFD_H) && defined(__NR_userfaultfd) && \
+    defined(UFFD_FEATURE_WP_ASYNC) && defined(PAGEMAP_SCAN)
+
+/* Write watches tracked by the kernel through asynchronous userfaultfd write protection,
+ * written pages are then retrieved and protected again with the PAGEMAP_SCAN ioctl. */
+
+static int uffd_fd = -1;
+static int pagemap_fd = -1;
+static BOOL use_kernel_writewatch;
+
+static void kernel_writewatch_init(void)
+{
+    struct uffdio_api uffdio_api;
+    const char *env = getenv( "WINE_DISABLE_KERNEL_WRITEWATCH" );
+
+    if (env && atoi( env )) return;
+
+    uffd_fd = syscall( __NR_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY );
+    if (uffd_fd == -1) return;
+
+    uffdio_api.api = UFFD_API;
+    uffdio_api.features = UFFD_FEATURE_WP_ASYNC | UFFD_FEATURE_WP_UNPOPULATED;
+    if (ioctl( uffd_fd, UFFDIO_API, &uffdio_api ) == -1 || uffdio_api.api != UFFD_API ||
+        (pagemap_fd = open( "/proc/self/pagemap", O_CLOEXEC | O_RDONLY )) == -1)
+    {
+        close( uffd_fd );
+        uffd_fd = -1;
+        return;
+    }
+    use_kernel_writewatch = TRUE;
+    TRACE( "using kernel write watches\n" );
+}
+
+static BOOL kernel_writewatch_reset( void *base, SIZE_T size )
+{
+    struct uffdio_writeprotect wp;
+
+    wp.range.start = (UINT_PTR)base;
+    wp.range.len = size;
+    wp.mode = UFFDIO_WRITEPROTECT_MODE_WP;
+    if (ioctl( uffd_fd, UFFDIO_WRITEPROTECT, &wp ) == -1)
+    {
+        ERR( "failed to write protect %p-%p, errno %d\n", base, (char *)base + size, errno );
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void kernel_writewatch_unregister( void *base, SIZE_T size )
+{
+    struct uffdio_range range;
+
+    range.start = (UINT_PTR)base;
+    range.len = size;
+    ioctl( uffd_fd, UFFDIO_UNREGISTER, &range );
+}
+
+static BOOL kernel_writewatch_register( void *base, SIZE_T size )
+{
+    struct uffdio_register reg;
+
+    /* huge pages would be reported as a whole */
+    madvise( base, size, MADV_NOHUGEPAGE );
+
+    reg.range.start = (UINT_PTR)base;
+    reg.range.len = size;
+    reg.mode = UFFDIO_REGISTER_MODE_WP;
+    if (ioctl( uffd_fd, UFFDIO_REGISTER, &reg ) == -1)
+    {
+        ERR( "failed to register %p-%p, errno %d\n", base, (char *)base + size, errno );
+        return FALSE;
+    }
+    if (kernel_writewatch_reset( base, size )) return TRUE;
+    kernel_writewatch_unregister( base, size );
+    return FALSE;
+}
+
+static BOOL kernel_get_write_watches( void *base, SIZE_T size, void **addresses, ULONG_PTR *count, BOOL reset )
+{
+    struct page_region regions[64];
+    struct pm_scan_arg arg;
+    ULONG_PTR pos = 0;
+    char *addr = base, *end = addr + size;
+    UINT64 page;
+    int i, ret;
+
+    memset( &arg, 0, sizeof(arg) );
+    arg.size = sizeof(arg);
+    arg.flags = PM_SCAN_CHECK_WPASYNC | (reset ? PM_SCAN_WP_MATCHING : 0);
+    arg.vec = (UINT_PTR)regions;
+    arg.vec_len = ARRAY_SIZE(regions);
+    arg.category_mask = PAGE_IS_WRITTEN;
+    arg.return_mask = PAGE_IS_WRITTEN;
+
+    while (pos < *count && addr < end)
+    {
+        arg.start = (UINT_PTR)addr;
+        arg.end = (UINT_PTR)end;
+        arg.max_pages = *count - pos;
+        if ((ret = ioctl( pagemap_fd, PAGEMAP_SCAN, &arg )) == -1)
+        {
+            ERR( "PAGEMAP_SCAN failed for %p-%p, errno %d\n", addr, end, errno );
+            return FALSE;
+        }
+        for (i = 0; i < ret; i++)
+            for (page = regions[i].start; page < regions[i].end && pos < *count; page += page_size)
+                addresses[pos++] = (void *)(UINT_PTR)page;
+        addr = (char *)(UINT_PTR)arg.walk_end;
+    }
+    *count = pos;
+    return TRUE;
+}
+
+#else  /* HAVE_LINUX_USERFAULTFD_H */
+
+static const BOOL use_kernel_writewatch = FALSE;
+
+static void kernel_writewatch_init(void) { }
+static BOOL kernel_writewatch_reset( void *base, SIZE_T size ) { return FALSE; }
+static void kernel_writewatch_unregister( void *base, SIZE_T size ) { }
+static BOOL kernel_writewatch_register( void *base, SIZE_T size ) { return FALSE; }
+static BOOL kernel_get_write_watches( void *base, SIZE_T size, void **addresses, ULONG_PTR *count, BOOL reset ) { return FALSE; }
+
+#endif  /* HAVE_LINUX_USERFAULTFD_H */
+
+
+/***********************************************************************
+ *           kernel_writewatch_fallback
+ *
+ * Switch a view back to write watches tracked through page protections,
+ * after the kernel tracking failed. All pages are reported as written
+ * until the next reset, since the writes seen by the kernel are lost.
+ * The csVirtual section must be held by caller.
+ */
+static void kernel_writewatch_fallback( struct file_view *view )
+{
+    WARN( "falling back to protection based write watches for %p-%p\n",
+          view->base, (char *)view->base + view->size );
+    kernel_writewatch_unregister( view->base, view->size );
+    view->protect &= ~VPROT_KERNEL_WRITEWATCH;
+}
+
+
 /***********************************************************************
  *           update_write_watches
  */
@@ -1488,6 +1664,10 @@ static NTSTATUS decommit_pages( struct file_view *view, size_t start, size_t siz
     if (wine_anon_mmap( (char *)view->base + start, size, PROT_NONE, MAP_FIXED ) != (void *)-1)
     {
         set_page_vprot_bits( (char *)view->base + start, size, 0, VPROT_COMMITTED );
+        /* the new mapping needs to be registered again */
+        if ((view->protect & VPROT_KERNEL_WRITEWATCH) &&
+            !kernel_writewatch_register( (char *)view->base + start, size ))
+            kernel_writewatch_fallback( view );
         return STATUS_SUCCESS;
     }
     return FILE_GetNtStatus();
@@ -2085,6 +2265,8 @@ void virtual_init(void)
 
     wine_mmap_add_free_area(address_space_start, (char *)user_space_limit - (char *)address_space_start);
     wine_mmap_enum_reserved_areas( remove_reserved_area_from_free, NULL, 0);
+
+    kernel_writewatch_init();
 }
 
 
@@ -2908,6 +3090,15 @@ NTSTATUS virtual_alloc_aligned( PVOID *ret, unsigned short zero_bits_64, SIZE_T
             else status = map_view( &view, base, size, alignment, type & MEM_TOP_DOWN, vprot, zero_bits_64 );
 
             if (status == STATUS_SUCCESS) base = view->base;
+
+            if (status == STATUS_SUCCESS && (vprot & VPROT_WRITEWATCH) && use_kernel_writewatch &&
+                kernel_writewatch_register( base, size ))
+            {
+                /* pages are write protected by the kernel instead */
+                view->protect |= VPROT_KERNEL_WRITEWATCH;
+                set_page_vprot_bits( base, size, 0, VPROT_WRITEWATCH );
+                mprotect_range( base, size, 0, 0 );
+            }
         }
     }
     else if (type & MEM_RESET)
@@ -3934,6 +4125,7 @@ NTSTATUS WINAPI NtFlushVirtualMemory( HANDLE process, LPCVOID *addr_ptr,
 NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T size, PVOID *addresses,
                                  ULONG_PTR *count, ULONG *granularity )
 {
+    struct file_view *view;
     NTSTATUS status = STATUS_SUCCESS;
     sigset_t sigset;
 
@@ -3951,12 +4143,19 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
 
     server_enter_uninterrupted_section( &csVirtual, &sigset );
 
-    if (is_write_watch_range( base, size ))
+    view = get_kernel_write_watch_view( base, size );
+    if (view && kernel_get_write_watches( base, size, addresses, count, flags & WRITE_WATCH_FLAG_RESET ))
+    {
+        *granularity = page_size;
+    }
+    else if (is_write_watch_range( base, size ))
     {
         ULONG_PTR pos = 0;
         char *addr = base;
         char *end = addr + size;
 
+        if (view) kernel_writewatch_fallback( view );
+
         while (pos < *count && addr < end)
         {
             if (!(get_page_vprot( addr ) & VPROT_WRITEWATCH)) addresses[pos++] = addr;
@@ -3979,6 +4178,7 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
  */
 NTSTATUS WINAPI NtResetWriteWatch( HANDLE process, PVOID base, SIZE_T size )
 {
+    struct file_view *view;
     NTSTATUS status = STATUS_SUCCESS;
     sigset_t sigset;
 
@@ -3992,7 +4192,14 @@ NTSTATUS WINAPI NtResetWriteWatch( HANDLE process, PVOID base, SIZE_T size )
     server_enter_uninterrupted_section( &csVirtual, &sigset );
 
     if (is_write_watch_range( base, size ))
-        reset_write_watches( base, size );
+    {
+        view = get_kernel_write_watch_view( base, size );
+        if (!view || !kernel_writewatch_reset( base, size ))
+        {
+            if (view) kernel_writewatch_fallback( view );
+            reset_write_watches( base, size );
+        }
+    }
     else
         status = STATUS_INVALID_PARAMETER;
 
@@ -470,6 +470,7 @@ DWORD WINAPI GetQueueStatus( UINT flags )
         ret = MAKELONG( reply->changed_bits & flags, reply->wake_bits & flags );
     }
     SERVER_END_REQ;
+    if (has_prefetched_messages()) ret |= MAKELONG( 0, flags & (QS_POSTMESSAGE | QS_ALLPOSTMESSAGE) );
     return ret;
 }
 
@@ -41,6 +41,7 @@
 #include "ddk/imm.h"
 #include "wine/unicode.h"
 #include "wine/server.h"
+#include "wine/list.h"
 #include "user_private.h"
 #include "win.h"
 #include "controls.h"
@@ -247,15 +248,33 @@ union packed_structs
     struct packed_hook_extra_info hook;
 };
 
+/* descriptor of message data passed through a shared memory section */
+struct packed_shared_data
+{
+    DWORD pid;      /* process that created the section */
+    DWORD serial;   /* serial number of the section in that process */
+    DWORD size;     /* size of the data at the start of the section */
+};
+
 /* description of the data fields that need to be packed along with a sent message */
 struct packed_message
 {
     union packed_structs ps;
+    struct packed_shared_data shared;
     int                  count;
     const void          *data[MAX_PACK_COUNT];
     size_t               size[MAX_PACK_COUNT];
 };
 
+/* posted messages that the server removed from the queue ahead of time */
+#define MAX_PREFETCHED_MESSAGES 16
+
+struct prefetched_messages
+{
+    unsigned int     count;
+    posted_message_t msgs[MAX_PREFETCHED_MESSAGES];
+};
+
 /* info about the message currently being received by the current thread */
 struct received_message_info
 {
@@ -747,6 +766,223 @@ static void map_wparam_WtoA( MSG *msg, BOOL remove )
 }
 
 
+/* large message data is passed to other processes through shared memory sections
+ * instead of being copied through the server; each section is used by a single
+ * message at a time, and is only reused once the receiver has replied; only
+ * sections of the minimum size are kept around, larger ones are freed right away */
+#define SHARED_DATA_THRESHOLD  0x10000   /* minimum data size to use a section */
+#define SHARED_DATA_MIN_SIZE   0x100000  /* minimum size of a section */
+#define MAX_FREE_SHARED_DATA   4         /* sections kept around for reuse */
+#define MAX_SHARED_DATA_VIEWS  8         /* sections of other processes kept mapped */
+
+struct shared_data_section
+{
+    struct list entry;
+    HANDLE      handle;
+    void       *base;
+    SIZE_T      size;
+    DWORD       serial;
+};
+
+struct shared_data_view
+{
+    DWORD       pid;
+    DWORD       serial;
+    HANDLE      process;
+    HANDLE      handle;
+    const void *base;
+    SIZE_T      size;
+};
+
+static struct list free_shared_data = LIST_INIT( free_shared_data );
+static unsigned int free_shared_data_count;
+static LONG shared_data_serial;
+static struct shared_data_view shared_data_views[MAX_SHARED_DATA_VIEWS];
+static unsigned int next_shared_data_view;
+static unsigned int next_shared_data_check;
+
+static CRITICAL_SECTION shared_data_crst;
+static CRITICAL_SECTION_DEBUG shared_data_critsect_debug =
+{
+    0, 0, &shared_data_crst,
+    { &shared_data_critsect_debug.ProcessLocksList, &shared_data_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": shared_data_crst") }
+};
+static CRITICAL_SECTION shared_data_crst = { &shared_data_critsect_debug, -1, 0, 0, 0, 0 };
+
+static void get_shared_data_name( WCHAR *name, DWORD pid, DWORD serial )
+{
+    static const WCHAR fmtW[] = {'_','_','w','i','n','e','_','m','s','g','_','d','a','t','a',
+                                 '_','%','x','_','%','x',0};
+    sprintfW( name, fmtW, pid, serial );
+}
+
+/* get a section of at least 'size' bytes for the data of a sent message */
+static struct shared_data_section *alloc_shared_data( SIZE_T size )
+{
+    struct shared_data_section *section;
+    WCHAR name[64];
+    int i;
+
+    EnterCriticalSection( &shared_data_crst );
+    LIST_FOR_EACH_ENTRY( section, &free_shared_data, struct shared_data_section, entry )
+    {
+        if (section->size < size) continue;
+        list_remove( &section->entry );
+        free_shared_data_count--;
+        LeaveCriticalSection( &shared_data_crst );
+        return section;
+    }
+    LeaveCriticalSection( &shared_data_crst );
+
+    if (!(section = HeapAlloc( GetProcessHeap(), 0, sizeof(*section) ))) return NULL;
+    section->size = max( SHARED_DATA_MIN_SIZE, (size + 0xffff) & ~0xffff );
+
+    /* a name may still be in use by a receiver of a previous process with the same id */
+    for (i = 0; i < 4; i++)
+    {
+        section->serial = InterlockedIncrement( &shared_data_serial );
+        get_shared_data_name( name, GetCurrentProcessId(), section->serial );
+        if (!(section->handle = CreateFileMappingW( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                                    0, section->size, name ))) break;
+        if (GetLastError() != ERROR_ALREADY_EXISTS)
+        {
+            if ((section->base = MapViewOfFile( section->handle, FILE_MAP_WRITE, 0, 0, 0 )))
+                return section;
+            CloseHandle( section->handle );
+            break;
+        }
+        CloseHandle( section->handle );
+    }
+    HeapFree( GetProcessHeap(), 0, section );
+    return NULL;
+}
+
+/* release the section of a sent message; it can only be reused if the receiver is done with it */
+static void release_shared_data( struct shared_data_section *section, BOOL reuse )
+{
+    if (!section) return;
+
+    if (reuse && section->size <= SHARED_DATA_MIN_SIZE)
+    {
+        EnterCriticalSection( &shared_data_crst );
+        if (free_shared_data_count < MAX_FREE_SHARED_DATA)
+        {
+            list_add_head( &free_shared_data, &section->entry );
+            free_shared_data_count++;
+            section = NULL;
+        }
+        LeaveCriticalSection( &shared_data_crst );
+        if (!section) return;
+    }
+    UnmapViewOfFile( section->base );
+    CloseHandle( section->handle );
+    HeapFree( GetProcessHeap(), 0, section );
+}
+
+/* move the last data field of a packed message to a shared section */
+static struct shared_data_section *pack_shared_data( struct packed_message *data )
+{
+    struct shared_data_section *section;
+    int last = data->count - 1;
+
+    if (last < 0 || data->size[last] < SHARED_DATA_THRESHOLD) return NULL;
+    if (!(section = alloc_shared_data( data->size[last] ))) return NULL;
+
+    memcpy( section->base, data->data[last], data->size[last] );
+    data->shared.pid    = GetCurrentProcessId();
+    data->shared.serial = section->serial;
+    data->shared.size   = data->size[last];
+    data->data[last] = &data->shared;
+    data->size[last] = sizeof(data->shared);
+    return section;
+}
+
+/* unmap a cached view of another process' section */
+static void free_shared_data_view( struct shared_data_view *view )
+{
+    UnmapViewOfFile( view->base );
+    CloseHandle( view->handle );
+    CloseHandle( view->process );
+    view->base = NULL;
+}
+
+/* drop a cached view if its sender has exited, the section is of no use anymore */
+static void check_shared_data_view( struct shared_data_view *view )
+{
+    if (view->base && !WaitForSingleObject( view->process, 0 )) free_shared_data_view( view );
+}
+
+/* copy the data described by a packed descriptor out of the sender's section */
+static BOOL unpack_shared_data( const struct packed_shared_data *shared, void *dst )
+{
+    struct shared_data_view *view = NULL, tmp;
+    MEMORY_BASIC_INFORMATION info;
+    WCHAR name[64];
+    BOOL ret = FALSE;
+    unsigned int i;
+
+    EnterCriticalSection( &shared_data_crst );
+    for (i = 0; i < MAX_SHARED_DATA_VIEWS; i++)
+    {
+        if (!shared_data_views[i].base) continue;
+        if (shared_data_views[i].pid != shared->pid) continue;
+        if (shared_data_views[i].serial != shared->serial) continue;
+        view = &shared_data_views[i];
+        break;
+    }
+    if (view)
+    {
+        /* check one of the other cached views at each use */
+        i = next_shared_data_check++ % MAX_SHARED_DATA_VIEWS;
+        if (&shared_data_views[i] != view) check_shared_data_view( &shared_data_views[i] );
+    }
+    else
+    {
+        for (i = 0; i < MAX_SHARED_DATA_VIEWS; i++) check_shared_data_view( &shared_data_views[i] );
+
+        get_shared_data_name( name, shared->pid, shared->serial );
+        tmp.pid     = shared->pid;
+        tmp.serial  = shared->serial;
+        tmp.process = NULL;
+        if (!(tmp.handle = OpenFileMappingW( FILE_MAP_READ, FALSE, name ))) goto done;
+        if (!(tmp.base = MapViewOfFile( tmp.handle, FILE_MAP_READ, 0, 0, 0 )))
+        {
+            CloseHandle( tmp.handle );
+            goto done;
+        }
+        VirtualQuery( tmp.base, &info, sizeof(info) );
+        tmp.size = info.RegionSize;
+
+        /* only small sections of a running sender are worth keeping mapped; the handle
+         * is kept open so that the name can't be reused while the view is cached */
+        if (tmp.size <= SHARED_DATA_MIN_SIZE &&
+            (tmp.process = OpenProcess( SYNCHRONIZE, FALSE, shared->pid )))
+        {
+            view = &shared_data_views[next_shared_data_view];
+            next_shared_data_view = (next_shared_data_view + 1) % MAX_SHARED_DATA_VIEWS;
+            if (view->base) free_shared_data_view( view );
+            *view = tmp;
+        }
+        else view = &tmp;
+    }
+    if (shared->size <= view->size)
+    {
+        memcpy( dst, view->base, shared->size );
+        ret = TRUE;
+    }
+    if (view == &tmp)
+    {
+        UnmapViewOfFile( tmp.base );
+        CloseHandle( tmp.handle );
+    }
+done:
+    LeaveCriticalSection( &shared_data_crst );
+    if (!ret) WARN( "failed to get shared data %x/%x size %u\n", shared->pid, shared->serial, shared->size );
+    return ret;
+}
+
+
 /***********************************************************************
  *		pack_message
  *
@@ -1235,7 +1471,19 @@ static BOOL unpack_message( HWND hwnd, UINT message, WPARAM *wparam, LPARAM *lpa
         COPYDATASTRUCT cds;
         if (size < sizeof(ps->cds)) return FALSE;
         cds.dwData = (ULONG_PTR)unpack_ptr( ps->cds.dwData );
-        if (ps->cds.lpData)
+        if (ps->cds.lpData && ps->cds.cbData >= SHARED_DATA_THRESHOLD &&
+            size == sizeof(ps->cds) + sizeof(struct packed_shared_data))
+        {
+            struct packed_shared_data shared = *(struct packed_shared_data *)(&ps->cds + 1);
+
+            if (shared.size != ps->cds.cbData) return FALSE;
+            if (!get_buffer_space( buffer, sizeof(ps->cds) + shared.size )) return FALSE;
+            ps = *buffer;
+            if (!unpack_shared_data( &shared, &ps->cds + 1 )) return FALSE;
+            cds.cbData = shared.size;
+            cds.lpData = &ps->cds + 1;
+        }
+        else if (ps->cds.lpData)
         {
             cds.cbData = ps->cds.cbData;
             cds.lpData = &ps->cds + 1;
@@ -2762,6 +3010,99 @@ static inline void call_sendmsg_callback( SENDASYNCPROC callback, HWND hwnd, UIN
 }
 
 
+static int peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags, UINT changed_mask );
+
+/***********************************************************************
+ *           has_prefetched_messages
+ */
+BOOL has_prefetched_messages(void)
+{
+    struct prefetched_messages *prefetched = get_user_thread_info()->prefetched;
+
+    return prefetched && prefetched->count;
+}
+
+
+/***********************************************************************
+ *           peek_prefetched_message
+ *
+ * Retrieve a posted message that was already returned by the server along
+ * with a previous one. These messages are older than any posted message
+ * still in the server queue.
+ */
+static BOOL peek_prefetched_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags )
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    struct prefetched_messages *prefetched = thread_info->prefetched;
+    shmlocal_t *shm = wine_get_shmlocal();
+    const posted_message_t *data;
+    unsigned int i;
+    MSG tmp;
+
+    if (!prefetched || !prefetched->count) return FALSE;
+    if (HIWORD(flags) && !(HIWORD(flags) & QS_POSTMESSAGE)) return FALSE;
+
+    /* sent messages are always processed before posted ones */
+    if (!shm || (shm->queue_bits & QS_SENDMESSAGE))
+    {
+        peek_message( &tmp, 0, 0, 0, PM_REMOVE | PM_QS_SENDMESSAGE, 0 );
+        if (!prefetched->count) return FALSE;
+    }
+
+    if (!first && !last) last = ~0;
+    if (hwnd == HWND_BROADCAST) hwnd = HWND_TOPMOST;
+    else if (hwnd && hwnd != (HWND)1) hwnd = WIN_GetFullHandle( hwnd );
+
+    for (i = 0; i < prefetched->count; i++)
+    {
+        HWND win = wine_server_ptr_handle( prefetched->msgs[i].win );
+
+        if (win && !IsWindow( win ))  /* the server would have dropped it */
+        {
+            prefetched->count--;
+            memmove( &prefetched->msgs[i], &prefetched->msgs[i + 1],
+                     (prefetched->count - i) * sizeof(prefetched->msgs[0]) );
+            i--;
+            continue;
+        }
+        if (prefetched->msgs[i].msg < first || prefetched->msgs[i].msg > last) continue;
+        if (hwnd == HWND_TOPMOST || hwnd == (HWND)1)
+        {
+            if (win) continue;
+        }
+        else if (hwnd && win != hwnd && !IsChild( hwnd, win )) continue;
+        break;
+    }
+    if (i == prefetched->count) return FALSE;
+
+    data = &prefetched->msgs[i];
+    msg->hwnd    = wine_server_ptr_handle( data->win );
+    msg->message = data->msg;
+    msg->wParam  = data->wparam;
+    msg->lParam  = data->lparam;
+    msg->time    = data->time;
+    msg->pt.x    = data->x;
+    msg->pt.y    = data->y;
+    if (flags & PM_REMOVE)
+    {
+        prefetched->count--;
+        memmove( &prefetched->msgs[i], &prefetched->msgs[i + 1],
+                 (prefetched->count - i) * sizeof(prefetched->msgs[0]) );
+    }
+
+    TRACE( "got prefetched msg %x (%s) hwnd %p wp %lx lp %lx\n",
+           msg->message, SPY_GetMsgName(msg->message, msg->hwnd), msg->hwnd, msg->wParam, msg->lParam );
+
+    msg->pt = point_phys_to_win_dpi( msg->hwnd, msg->pt );
+    thread_info->GetMessagePosVal = MAKELONG( msg->pt.x, msg->pt.y );
+    thread_info->GetMessageTimeVal = msg->time;
+    thread_info->GetMessageExtraInfoVal = 0;
+    thread_info->msg_source = msg_source_unavailable;
+    HOOK_CallHooks( WH_GETMESSAGE, HC_ACTION, flags & PM_REMOVE, (LPARAM)msg, TRUE );
+    return TRUE;
+}
+
+
 /***********************************************************************
  *           peek_message
  *
@@ -2777,9 +3118,12 @@ static int peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags,
     struct received_message_info info, *old_info;
     unsigned int hw_id = 0;  /* id of previous hardware message */
     void *buffer;
-    size_t buffer_size = 256;
+    size_t buffer_size = 512;
+    unsigned int prefetch = 0;
     shmlocal_t *shm = wine_get_shmlocal();
 
+    if (peek_prefetched_message( msg, hwnd, first, last, flags )) return 1;
+
     /* From time to time we are forced to do a wineserver call in
      * order to update last_msg_time stored for each server thread. */
     if (shm && GetTickCount() - thread_info->last_get_msg < 500)
@@ -2796,12 +3140,30 @@ static int peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags,
     if (!first && !last) last = ~0;
     if (hwnd == HWND_BROADCAST) hwnd = HWND_TOPMOST;
 
+    /* without filters, let the server return the following posted messages too */
+    if (shm && (flags & PM_REMOVE) && !hwnd && !first && last == ~0U &&
+        (!HIWORD(flags) || (HIWORD(flags) & QS_POSTMESSAGE)))
+    {
+        if (!thread_info->prefetched)
+            thread_info->prefetched = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                                 sizeof(*thread_info->prefetched) );
+        if (thread_info->prefetched)
+            prefetch = min( MAX_PREFETCHED_MESSAGES, buffer_size / sizeof(posted_message_t) );
+    }
+
     for (;;)
     {
         NTSTATUS res;
         size_t size = 0;
         const message_data_t *msg_data = buffer;
 
+        /* a nested call may have retrieved older posted messages in the meantime */
+        if (peek_prefetched_message( msg, hwnd, first, last, flags ))
+        {
+            HeapFree( GetProcessHeap(), 0, buffer );
+            return 1;
+        }
+
         thread_info->msg_source = prev_source;
 
         if (shm) thread_info->last_get_msg = GetTickCount();
@@ -2815,10 +3177,18 @@ static int peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags,
             req->hw_id     = hw_id;
             req->wake_mask = changed_mask & (QS_SENDMESSAGE | QS_SMRESULT);
             req->changed_mask = changed_mask;
+            req->prefetch  = thread_info->prefetched && !thread_info->prefetched->count ? prefetch : 0;
             wine_server_set_reply( req, buffer, buffer_size );
             if (!(res = wine_server_call( req )))
             {
                 size = wine_server_reply_size( reply );
+                if (reply->prefetched)
+                {
+                    memcpy( thread_info->prefetched->msgs, buffer,
+                            reply->prefetched * sizeof(posted_message_t) );
+                    thread_info->prefetched->count = reply->prefetched;
+                    size = 0;
+                }
                 info.type        = reply->type;
                 info.msg.hwnd    = wine_server_ptr_handle( reply->win );
                 info.msg.message = reply->msg;
@@ -3143,9 +3513,11 @@ static DWORD wait_objects( DWORD count, const HANDLE *handles, DWORD timeout,
  *		put_message_in_queue
  *
  * Put a sent message into the destination queue.
- * For inter-process message, reply_size is set to expected size of reply data.
+ * For inter-process message, reply_size is set to expected size of reply data,
+ * and shared is set to the section holding large message data, if any.
  */
-static BOOL put_message_in_queue( const struct send_message_info *info, size_t *reply_size )
+static BOOL put_message_in_queue( const struct send_message_info *info, size_t *reply_size,
+                                  struct shared_data_section **shared )
 {
     struct packed_message data;
     message_data_t msg_data;
@@ -3175,6 +3547,11 @@ static BOOL put_message_in_queue( const struct send_message_info *info, size_t *
             WARN( "cannot pack message %x\n", info->msg );
             return FALSE;
         }
+        /* after a timeout the receiver may still process the message once the sender is
+         * gone, the data then has to be kept by the server */
+        if (shared && info->type == MSG_OTHER_PROCESS && info->msg == WM_COPYDATA &&
+            timeout == TIMEOUT_INFINITE)
+            *shared = pack_shared_data( &data );
     }
     else if (info->type == MSG_CALLBACK)
     {
@@ -3264,20 +3641,31 @@ static LRESULT retrieve_reply( const struct send_message_info *info,
  */
 static LRESULT send_inter_thread_message( const struct send_message_info *info, LRESULT *res_ptr )
 {
+    struct shared_data_section *shared = NULL;
     size_t reply_size = 0;
+    LRESULT ret;
 
     TRACE( "hwnd %p msg %x (%s) wp %lx lp %lx\n",
            info->hwnd, info->msg, SPY_GetMsgName(info->msg, info->hwnd), info->wparam, info->lparam );
 
     USER_CheckNotLock();
 
-    if (!put_message_in_queue( info, &reply_size )) return 0;
+    if (!put_message_in_queue( info, &reply_size, &shared ))
+    {
+        release_shared_data( shared, TRUE );
+        return 0;
+    }
 
     /* there's no reply to wait for on notify/callback messages */
     if (info->type == MSG_NOTIFY || info->type == MSG_CALLBACK) return 1;
 
     wait_message_reply( info->flags );
-    return retrieve_reply( info, reply_size, res_ptr );
+    ret = retrieve_reply( info, reply_size, res_ptr );
+
+    /* without a timeout, the message is gone once the reply has been retrieved,
+     * but the section is only reused if the receiver did get to it */
+    release_shared_data( shared, ret );
+    return ret;
 }
 
 
@@ -3744,7 +4132,7 @@ BOOL WINAPI PostMessageW( HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam )
 
     if (USER_IsExitingThread( info.dest_tid )) return TRUE;
 
-    return put_message_in_queue( &info, NULL );
+    return put_message_in_queue( &info, NULL, NULL );
 }
 
 
@@ -3779,7 +4167,7 @@ BOOL WINAPI PostThreadMessageW( DWORD thread, UINT msg, WPARAM wparam, LPARAM lp
     info.wparam   = wparam;
     info.lparam   = lparam;
     info.flags    = 0;
-    return put_message_in_queue( &info, NULL );
+    return put_message_in_queue( &info, NULL, NULL );
 }
 
 
@@ -4235,6 +4623,10 @@ DWORD WINAPI MsgWaitForMultipleObjectsEx( DWORD count, const HANDLE *pHandles,
         return WAIT_FAILED;
     }
 
+    /* the server doesn't know about the posted messages it already returned */
+    if ((flags & MWMO_INPUTAVAILABLE) && (mask & QS_POSTMESSAGE) && has_prefetched_messages())
+        return WAIT_OBJECT_0 + count;
+
     /* add the queue to the handle list */
     for (i = 0; i < count; i++) handles[i] = pHandles[i];
     handles[count] = get_server_queue_handle();
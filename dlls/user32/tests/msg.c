@@ -10678,6 +10678,46 @@ todo_wine
     while (i > 0) KillTimer(NULL, ids[--i]);
 }
 
+static void test_many_timers(void)
+{
+    static BOOL seen[1000];
+    unsigned int i, count = 0;
+    DWORD start;
+    HWND hwnd;
+    MSG msg;
+
+    hwnd = CreateWindowA("TestWindowClass", NULL, WS_OVERLAPPEDWINDOW,
+                         CW_USEDEFAULT, CW_USEDEFAULT, 300, 300, 0, NULL, NULL, 0);
+    ok(hwnd != 0, "CreateWindow failed\n");
+
+    for (i = 0; i < ARRAY_SIZE(seen); i++)
+        ok(SetTimer(hwnd, i + 1, 10 + i % 50, NULL) == i + 1, "SetTimer %u failed\n", i + 1);
+
+    /* replacing a timer keeps a single instance of it */
+    ok(SetTimer(hwnd, 1, 10, NULL) == 1, "SetTimer failed\n");
+
+    start = GetTickCount();
+    while (count < ARRAY_SIZE(seen) && GetTickCount() - start < 5000)
+    {
+        while (PeekMessageA(&msg, hwnd, WM_TIMER, WM_TIMER, PM_REMOVE))
+        {
+            ok(msg.wParam >= 1 && msg.wParam <= ARRAY_SIZE(seen), "unexpected id %lu\n", msg.wParam);
+            if (msg.wParam < 1 || msg.wParam > ARRAY_SIZE(seen)) continue;
+            if (!seen[msg.wParam - 1]) count++;
+            seen[msg.wParam - 1] = TRUE;
+        }
+        Sleep(10);
+    }
+    ok(count == ARRAY_SIZE(seen), "got %u timers\n", count);
+
+    for (i = 0; i < ARRAY_SIZE(seen); i++)
+        ok(KillTimer(hwnd, i + 1), "KillTimer %u failed\n", i + 1);
+    ok(!KillTimer(hwnd, 1), "KillTimer succeeded\n");
+
+    DestroyWindow(hwnd);
+    flush_events();
+}
+
 static void test_timers_exception(DWORD code)
 {
     UINT_PTR id;
@@ -12697,6 +12737,7 @@ static void test_PeekMessage3(void)
     HWND hwnd;
     BOOL ret;
     MSG msg;
+    UINT i;
 
     hwnd = CreateWindowA("TestWindowClass", "PeekMessage3", WS_OVERLAPPEDWINDOW,
                          10, 10, 800, 800, NULL, NULL, NULL, NULL);
@@ -12817,6 +12858,29 @@ static void test_PeekMessage3(void)
     ret = PeekMessageA(&msg, NULL, 0, 0, 0);
     ok(!ret, "expected PeekMessage to return FALSE, got %u\n", ret);
 
+    /* Filters still apply once the first of many posted messages is retrieved. */
+
+    for (i = 0; i < 20; i++) PostMessageA(hwnd, WM_USER + i, i, 0);
+    ret = PeekMessageA(&msg, NULL, 0, 0, PM_REMOVE);
+    ok(ret && msg.message == WM_USER, "msg.message = %u instead of WM_USER\n", msg.message);
+    ret = GetQueueStatus(QS_POSTMESSAGE);
+    ok(HIWORD(ret) & QS_POSTMESSAGE, "GetQueueStatus returned %#x\n", ret);
+    ret = PeekMessageA(&msg, NULL, WM_USER + 5, WM_USER + 5, PM_REMOVE);
+    ok(ret && msg.message == WM_USER + 5 && msg.wParam == 5, "msg.message = %u instead of WM_USER + 5\n", msg.message);
+    ret = PeekMessageA(&msg, NULL, WM_USER + 15, WM_USER + 15, PM_NOREMOVE);
+    ok(ret && msg.message == WM_USER + 15, "msg.message = %u instead of WM_USER + 15\n", msg.message);
+    ret = PeekMessageA(&msg, (HWND)-1, 0, 0, PM_NOREMOVE);
+    ok(!ret, "expected PeekMessage to return FALSE, got %u\n", ret);
+    for (i = 1; i < 20; i++)
+    {
+        if (i == 5) continue;
+        ret = GetMessageA(&msg, NULL, 0, 0);
+        ok(ret && msg.message == WM_USER + i && msg.wParam == i,
+           "%u: msg.message = %u instead of WM_USER + %u\n", i, msg.message, i);
+    }
+    ret = PeekMessageA(&msg, NULL, 0, 0, 0);
+    ok(!ret, "expected PeekMessage to return FALSE, got %u\n", ret);
+
     DestroyWindow(hwnd);
     flush_events();
 }
@@ -18315,6 +18379,7 @@ START_TEST(msg)
     test_accelerators();
     test_timers();
     test_timers_no_wnd();
+    test_many_timers();
     test_timers_exceptions();
     if (hCBT_hook)
     {
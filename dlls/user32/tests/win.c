@@ -9544,6 +9544,69 @@ static void test_window_from_point(const char *argv0)
     DestroyWindow(hwnd);
 }
 
+static void test_window_from_point_many_children(void)
+{
+    HWND hwnd, win, child[100];
+    POINT pt;
+    int i;
+
+    hwnd = CreateWindowExA(0, "MainWindowClass", NULL, WS_POPUP | WS_VISIBLE,
+            100, 100, 200, 200, 0, 0, NULL, NULL);
+    ok(hwnd != 0, "CreateWindowEx failed\n");
+
+    pt.x = pt.y = 150;
+    if (WindowFromPoint(pt) != hwnd)
+    {
+        skip("there's another window covering test window\n");
+        DestroyWindow(hwnd);
+        return;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(child); i++)
+    {
+        child[i] = CreateWindowExA(0, "button", "button", WS_CHILD | WS_VISIBLE,
+                (i % 10) * 20, (i / 10) * 20, 20, 20, hwnd, 0, NULL, NULL);
+        ok(child[i] != 0, "CreateWindowEx failed\n");
+    }
+
+    for (i = 0; i < ARRAY_SIZE(child); i++)
+    {
+        pt.x = 110 + (i % 10) * 20;
+        pt.y = 110 + (i / 10) * 20;
+        win = WindowFromPoint(pt);
+        ok(win == child[i], "%d: WindowFromPoint returned %p, expected %p\n", i, win, child[i]);
+    }
+
+    /* move a child over another one */
+    SetWindowPos(child[0], HWND_TOP, 180, 180, 20, 20, SWP_NOACTIVATE);
+    pt.x = pt.y = 110;
+    win = WindowFromPoint(pt);
+    ok(win == hwnd, "WindowFromPoint returned %p, expected %p\n", win, hwnd);
+    pt.x = pt.y = 290;
+    win = WindowFromPoint(pt);
+    ok(win == child[0], "WindowFromPoint returned %p, expected %p\n", win, child[0]);
+
+    SetWindowPos(child[0], HWND_BOTTOM, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+    win = WindowFromPoint(pt);
+    ok(win == child[99], "WindowFromPoint returned %p, expected %p\n", win, child[99]);
+
+    ShowWindow(child[99], SW_HIDE);
+    win = WindowFromPoint(pt);
+    ok(win == child[0], "WindowFromPoint returned %p, expected %p\n", win, child[0]);
+
+    DestroyWindow(child[0]);
+    win = WindowFromPoint(pt);
+    ok(win == hwnd, "WindowFromPoint returned %p, expected %p\n", win, hwnd);
+
+    /* make a child larger than the others */
+    SetWindowPos(child[55], HWND_TOP, 0, 0, 200, 200, SWP_NOACTIVATE);
+    pt.x = pt.y = 105;
+    win = WindowFromPoint(pt);
+    ok(win == child[55], "WindowFromPoint returned %p, expected %p\n", win, child[55]);
+
+    DestroyWindow(hwnd);
+}
+
 static void test_map_points(void)
 {
     BOOL ret;
@@ -11813,7 +11876,8 @@ static void other_process_proc(HWND hwnd)
 {
     HANDLE window_ready_event, test_done_event;
     WINDOWPLACEMENT wp;
-    DWORD ret;
+    DWORD ret, pid;
+    RECT rect;
 
     window_ready_event = OpenEventA(EVENT_ALL_ACCESS, FALSE, "test_opw_window");
     ok(!!window_ready_event, "OpenEvent failed.\n");
@@ -11827,6 +11891,19 @@ static void other_process_proc(HWND hwnd)
     ok(ret, "Unexpected ret %#x.\n", ret);
     ok(wp.showCmd == SW_SHOWNORMAL, "Unexpected showCmd %#x.\n", wp.showCmd);
     ok(!wp.flags, "Unexpected flags %#x.\n", wp.flags);
+    ok(IsWindow(hwnd), "IsWindow failed.\n");
+    ok(IsWindowVisible(hwnd), "IsWindowVisible failed.\n");
+    ok(!GetParent(hwnd), "Unexpected parent %p.\n", GetParent(hwnd));
+    ok(GetAncestor(hwnd, GA_PARENT) == GetDesktopWindow(), "Unexpected ancestor %p.\n",
+       GetAncestor(hwnd, GA_PARENT));
+    ok(GetWindowThreadProcessId(hwnd, &pid), "GetWindowThreadProcessId failed.\n");
+    ok(pid != GetCurrentProcessId(), "Unexpected process id %#x.\n", pid);
+    ok((GetWindowLongA(hwnd, GWL_STYLE) & (WS_POPUP | WS_VISIBLE)) == (WS_POPUP | WS_VISIBLE),
+       "Unexpected style %#x.\n", GetWindowLongA(hwnd, GWL_STYLE));
+    ret = GetWindowRect(hwnd, &rect);
+    ok(ret, "Unexpected ret %#x.\n", ret);
+    ok(rect.left == 100 && rect.top == 100 && rect.right == 200 && rect.bottom == 200,
+       "Unexpected rect %s.\n", wine_dbgstr_rect(&rect));
     SetEvent(test_done_event);
 
     /* SW_SHOWMAXIMIZED */
@@ -11917,6 +11994,112 @@ static void test_other_process_window(const char *argv0)
     DestroyWindow(hwnd);
 }
 
+static DWORD copydata_received;
+
+static LRESULT WINAPI copydata_wnd_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
+{
+    if (msg == WM_COPYDATA)
+    {
+        const COPYDATASTRUCT *cds = (const COPYDATASTRUCT *)lparam;
+        const BYTE *data = cds->lpData;
+        DWORD i;
+
+        if (cds->cbData && !data) return 0;
+        for (i = 0; i < cds->cbData; i++)
+            if (data[i] != (BYTE)(i * 7 + cds->dwData)) return 0;
+        copydata_received = cds->cbData;
+        return cds->cbData + cds->dwData;
+    }
+    if (msg == WM_USER)  /* keep the receiver busy */
+    {
+        Sleep(500);
+        return 0;
+    }
+    if (msg == WM_USER + 1) return copydata_received;
+    return DefWindowProcA(hwnd, msg, wparam, lparam);
+}
+
+static void copydata_proc(HWND hwnd)
+{
+    static const DWORD sizes[] = {0, 16, 0x10000 - 1, 0x10000, 0x100000, 0x100000, 0x10000, 0x300000};
+    COPYDATASTRUCT cds;
+    DWORD_PTR res;
+    BYTE *data;
+    DWORD i, j;
+    LRESULT ret;
+
+    data = HeapAlloc(GetProcessHeap(), 0, 0x300000);
+    for (i = 0; i < ARRAY_SIZE(sizes); i++)
+    {
+        cds.dwData = i;
+        cds.cbData = sizes[i];
+        cds.lpData = sizes[i] ? data : NULL;
+        for (j = 0; j < sizes[i]; j++) data[j] = j * 7 + i;
+        ret = SendMessageA(hwnd, WM_COPYDATA, 0, (LPARAM)&cds);
+        ok(ret == sizes[i] + i, "%u: got %lx\n", i, ret);
+    }
+
+    cds.dwData = 1;
+    cds.cbData = 0x200000;
+    cds.lpData = data;
+    for (j = 0; j < cds.cbData; j++) data[j] = j * 7 + 1;
+    ret = SendMessageTimeoutA(hwnd, WM_COPYDATA, 0, (LPARAM)&cds, SMTO_NORMAL, 5000, &res);
+    ok(ret, "SendMessageTimeout failed, error %u\n", GetLastError());
+    ok(res == cds.cbData + 1, "got %lx\n", res);
+
+    /* the data is still delivered when the sender times out */
+    PostMessageA(hwnd, WM_USER, 0, 0);
+    Sleep(100);
+    cds.dwData = 2;
+    cds.cbData = 0x180000;
+    cds.lpData = data;
+    for (j = 0; j < cds.cbData; j++) data[j] = j * 7 + 2;
+    SetLastError(0xdeadbeef);
+    ret = SendMessageTimeoutA(hwnd, WM_COPYDATA, 0, (LPARAM)&cds, SMTO_NORMAL, 50, &res);
+    ok(!ret, "SendMessageTimeout succeeded\n");
+    ok(GetLastError() == ERROR_TIMEOUT, "got error %u\n", GetLastError());
+    memset(data, 0, cds.cbData);
+    ret = SendMessageA(hwnd, WM_USER + 1, 0, 0);
+    ok(ret == cds.cbData, "got %lx\n", ret);
+
+    HeapFree(GetProcessHeap(), 0, data);
+}
+
+static void test_other_process_copydata(const char *argv0)
+{
+    PROCESS_INFORMATION info;
+    STARTUPINFOA startup;
+    char cmd[MAX_PATH];
+    WNDCLASSA cls;
+    HWND hwnd;
+    MSG msg;
+
+    memset(&cls, 0, sizeof(cls));
+    cls.lpfnWndProc = copydata_wnd_proc;
+    cls.hInstance = GetModuleHandleA(NULL);
+    cls.lpszClassName = "copydata_class";
+    RegisterClassA(&cls);
+
+    hwnd = CreateWindowExA(0, "copydata_class", NULL, WS_POPUP, 0, 0, 100, 100, 0, 0, NULL, NULL);
+    ok(!!hwnd, "CreateWindowEx failed.\n");
+
+    sprintf(cmd, "%s win copydata %p", argv0, hwnd);
+    memset(&startup, 0, sizeof(startup));
+    startup.cb = sizeof(startup);
+
+    ok(CreateProcessA(NULL, cmd, NULL, NULL, FALSE, 0, NULL, NULL,
+            &startup, &info), "CreateProcess failed.\n");
+
+    while (MsgWaitForMultipleObjects(1, &info.hProcess, FALSE, 10000, QS_ALLINPUT) == WAIT_OBJECT_0 + 1)
+        while (PeekMessageA(&msg, 0, 0, 0, PM_REMOVE)) DispatchMessageA(&msg);
+
+    wait_child_process(info.hProcess);
+    CloseHandle(info.hProcess);
+    CloseHandle(info.hThread);
+    DestroyWindow(hwnd);
+    UnregisterClassA("copydata_class", GetModuleHandleA(NULL));
+}
+
 START_TEST(win)
 {
     char **argv;
@@ -11956,6 +12139,11 @@ START_TEST(win)
             other_process_proc(hwnd);
             return;
         }
+        else if (!strcmp(argv[2], "copydata"))
+        {
+            copydata_proc(hwnd);
+            return;
+        }
     }
 
     if (argc == 3 && !strcmp(argv[2], "winproc_limit"))
@@ -12002,6 +12190,7 @@ START_TEST(win)
     /* Add the tests below this line */
     test_child_window_from_point();
     test_window_from_point(argv[0]);
+    test_window_from_point_many_children();
     test_thick_child_size(hwndMain);
     test_fullscreen();
     test_hwnd_message();
@@ -12082,6 +12271,7 @@ START_TEST(win)
     test_window_placement();
     test_arrange_iconic_windows();
     test_other_process_window(argv[0]);
+    test_other_process_copydata(argv[0]);
 
     /* add the tests above this line */
     if (hhook) UnhookWindowsHookEx(hhook);
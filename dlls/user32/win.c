@@ -308,6 +308,152 @@ static void free_window_handle( HWND hwnd )
 }
 
 
+/*******************************************************************
+ *           get_shm_window
+ *
+ * Find the entry of a window in the shared memory window table.
+ */
+static const shm_window_t *get_shm_window( const shmglobal_t *shm, user_handle_t handle )
+{
+    const shm_window_t *win;
+    int index = ((handle & 0xffff) - FIRST_USER_HANDLE) >> 1;
+    WORD generation = handle >> 16;
+
+    if (index < 0 || index >= NB_USER_HANDLES) return NULL;
+    win = &shm->windows[index];
+    if (!win->handle) return NULL;
+    if (generation && generation != 0xffff && generation != win->handle >> 16) return NULL;
+    return win;
+}
+
+/* the server increments the sequence counter before and after updating the window table */
+static inline BOOL shm_window_read_begin( const shmglobal_t *shm, unsigned int *seq )
+{
+    *seq = *(volatile const unsigned int *)&shm->window_seq;
+    __sync_synchronize();
+    return !(*seq & 1);
+}
+
+static inline BOOL shm_window_read_end( const shmglobal_t *shm, unsigned int seq )
+{
+    __sync_synchronize();
+    return *(volatile const unsigned int *)&shm->window_seq == seq;
+}
+
+
+/*******************************************************************
+ *           get_shm_window_info
+ *
+ * Retrieve the information of a window from the shared memory window
+ * table. Returns FALSE if the server needs to be queried instead.
+ */
+static BOOL get_shm_window_info( HWND hwnd, shm_window_t *info )
+{
+    const shmglobal_t *shm = wine_get_shmglobal();
+    const shm_window_t *win;
+    unsigned int seq;
+
+    if (!shm || !shm_window_read_begin( shm, &seq )) return FALSE;
+    if (!(win = get_shm_window( shm, wine_server_user_handle( hwnd )))) return FALSE;
+    *info = *win;
+    return shm_window_read_end( shm, seq );
+}
+
+
+/*******************************************************************
+ *           get_shm_window_parents
+ *
+ * Retrieve the parents of a window from the shared memory window table.
+ * Returns the number of parents, or -1 if the server needs to be queried.
+ */
+static int get_shm_window_parents( HWND hwnd, user_handle_t *list, int size )
+{
+    const shmglobal_t *shm = wine_get_shmglobal();
+    const shm_window_t *win;
+    unsigned int seq;
+    int count = 0;
+
+    if (!shm || !shm_window_read_begin( shm, &seq )) return -1;
+    if (!(win = get_shm_window( shm, wine_server_user_handle( hwnd )))) return -1;
+    while (win->parent)
+    {
+        if (count < size) list[count] = win->parent;
+        if (++count >= NB_USER_HANDLES) return -1;
+        if (!(win = get_shm_window( shm, win->parent ))) return -1;
+    }
+    if (!shm_window_read_end( shm, seq )) return -1;
+    return count;
+}
+
+
+/*******************************************************************
+ *           get_shm_window_rects
+ *
+ * Retrieve the rectangles of a window from the shared memory window
+ * table. Returns FALSE if the server needs to be queried instead.
+ */
+static BOOL get_shm_window_rects( HWND hwnd, enum coords_relative relative,
+                                  RECT *rectWindow, RECT *rectClient, UINT dpi )
+{
+    const shmglobal_t *shm = wine_get_shmglobal();
+    const shm_window_t *win, *parent;
+    RECT window_rect, client_rect, rect;
+    unsigned int seq;
+    int count = 0;
+
+    if (!shm || !shm_window_read_begin( shm, &seq )) return FALSE;
+    if (!(win = get_shm_window( shm, wine_server_user_handle( hwnd )))) return FALSE;
+    if (win->dpi != dpi) return FALSE;  /* let the server do the DPI mapping */
+
+    SetRect( &window_rect, win->window.left, win->window.top, win->window.right, win->window.bottom );
+    SetRect( &client_rect, win->client.left, win->client.top, win->client.right, win->client.bottom );
+
+    switch (relative)
+    {
+    case COORDS_CLIENT:
+        rect = client_rect;
+        OffsetRect( &window_rect, -rect.left, -rect.top );
+        OffsetRect( &client_rect, -rect.left, -rect.top );
+        if (win->ex_style & WS_EX_LAYOUTRTL) mirror_rect( &rect, &window_rect );
+        break;
+    case COORDS_WINDOW:
+        rect = window_rect;
+        OffsetRect( &window_rect, -rect.left, -rect.top );
+        OffsetRect( &client_rect, -rect.left, -rect.top );
+        if (win->ex_style & WS_EX_LAYOUTRTL) mirror_rect( &rect, &client_rect );
+        break;
+    case COORDS_PARENT:
+        if (!win->parent) break;
+        if (!(parent = get_shm_window( shm, win->parent ))) return FALSE;
+        if (parent->ex_style & WS_EX_LAYOUTRTL)
+        {
+            SetRect( &rect, parent->client.left, parent->client.top,
+                     parent->client.right, parent->client.bottom );
+            mirror_rect( &rect, &window_rect );
+            mirror_rect( &rect, &client_rect );
+        }
+        break;
+    case COORDS_SCREEN:
+        for (parent = win; parent->parent; count++)
+        {
+            if (count >= NB_USER_HANDLES) return FALSE;
+            if (!(parent = get_shm_window( shm, parent->parent ))) return FALSE;
+            if (!parent->parent) break;  /* desktop window */
+            OffsetRect( &window_rect, parent->client.left, parent->client.top );
+            OffsetRect( &client_rect, parent->client.left, parent->client.top );
+        }
+        break;
+    default:
+        return FALSE;
+    }
+
+    if (!shm_window_read_end( shm, seq )) return FALSE;
+    if (rectWindow) *rectWindow = window_rect;
+    if (rectClient) *rectClient = client_rect;
+    return TRUE;
+}
+
+
 /*******************************************************************
  *           list_window_children
  *
@@ -398,14 +544,17 @@ static HWND *list_window_parents( HWND hwnd )
 
     for (;;)
     {
-        count = 0;
-        SERVER_START_REQ( get_window_parents )
+        if ((count = get_shm_window_parents( hwnd, (user_handle_t *)list, size - 1 )) < 0)
         {
-            req->handle = wine_server_user_handle( hwnd );
-            wine_server_set_reply( req, list, (size-1) * sizeof(user_handle_t) );
-            if (!wine_server_call( req )) count = reply->count;
+            count = 0;
+            SERVER_START_REQ( get_window_parents )
+            {
+                req->handle = wine_server_user_handle( hwnd );
+                wine_server_set_reply( req, list, (size-1) * sizeof(user_handle_t) );
+                if (!wine_server_call( req )) count = reply->count;
+            }
+            SERVER_END_REQ;
         }
-        SERVER_END_REQ;
         if (!count) goto empty;
         if (size > count)
         {
@@ -935,6 +1084,8 @@ BOOL WIN_GetRectangles( HWND hwnd, enum coords_relative relative, RECT *rectWind
     }
 
 other_process:
+    if (get_shm_window_rects( hwnd, relative, rectWindow, rectClient, get_thread_dpi() )) return TRUE;
+
     SERVER_START_REQ( get_window_rectangles )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -2356,11 +2507,16 @@ static LONG_PTR WIN_GetWindowLong( HWND hwnd, INT offset, UINT size, BOOL unicod
 
     if (wndPtr == WND_OTHER_PROCESS)
     {
+        shm_window_t info;
+
         if (offset == GWLP_WNDPROC)
         {
             SetLastError( ERROR_ACCESS_DENIED );
             return 0;
         }
+        if ((offset == GWL_STYLE || offset == GWL_EXSTYLE) && get_shm_window_info( hwnd, &info ))
+            return offset == GWL_STYLE ? info.style : info.ex_style;
+
         SERVER_START_REQ( set_window_info )
         {
             req->handle = wine_server_user_handle( hwnd );
@@ -3013,6 +3169,7 @@ INT WINAPI GetWindowTextLengthW( HWND hwnd )
 BOOL WINAPI IsWindow( HWND hwnd )
 {
     WND *ptr;
+    shm_window_t info;
     BOOL ret;
 
     if (!(ptr = WIN_GetPtr( hwnd ))) return FALSE;
@@ -3025,6 +3182,8 @@ BOOL WINAPI IsWindow( HWND hwnd )
     }
 
     /* check other processes */
+    if (get_shm_window_info( hwnd, &info )) return TRUE;
+
     SERVER_START_REQ( get_window_info )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -3041,6 +3200,7 @@ BOOL WINAPI IsWindow( HWND hwnd )
 DWORD WINAPI GetWindowThreadProcessId( HWND hwnd, LPDWORD process )
 {
     WND *ptr;
+    shm_window_t info;
     DWORD tid = 0;
 
     if (!(ptr = WIN_GetPtr( hwnd )))
@@ -3059,6 +3219,12 @@ DWORD WINAPI GetWindowThreadProcessId( HWND hwnd, LPDWORD process )
     }
 
     /* check other processes */
+    if (get_shm_window_info( hwnd, &info ))
+    {
+        if (process) *process = info.pid;
+        return info.tid;
+    }
+
     SERVER_START_REQ( get_window_info )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -3089,7 +3255,17 @@ HWND WINAPI GetParent( HWND hwnd )
     if (wndPtr == WND_DESKTOP) return 0;
     if (wndPtr == WND_OTHER_PROCESS)
     {
-        LONG style = GetWindowLongW( hwnd, GWL_STYLE );
+        shm_window_t info;
+        LONG style;
+
+        if (get_shm_window_info( hwnd, &info ))
+        {
+            if (info.style & WS_POPUP) retvalue = wine_server_ptr_handle( info.owner );
+            else if (info.style & WS_CHILD) retvalue = wine_server_ptr_handle( info.parent );
+            return retvalue;
+        }
+
+        style = GetWindowLongW( hwnd, GWL_STYLE );
         if (style & (WS_POPUP | WS_CHILD))
         {
             SERVER_START_REQ( get_window_tree )
@@ -3138,6 +3314,10 @@ HWND WINAPI GetAncestor( HWND hwnd, UINT type )
         }
         else /* need to query the server */
         {
+            shm_window_t info;
+
+            if (get_shm_window_info( hwnd, &info )) return wine_server_ptr_handle( info.parent );
+
             SERVER_START_REQ( get_window_tree )
             {
                 req->handle = wine_server_user_handle( hwnd );
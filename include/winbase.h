@@ -1832,6 +1832,7 @@ WINBASEAPI BOOL        WINAPI CopyFileExW(LPCWSTR, LPCWSTR, LPPROGRESS_ROUTINE,
 #define                       CopyFileEx WINELIB_NAME_AW(CopyFileEx)
 WINADVAPI  BOOL        WINAPI CopySid(DWORD,PSID,PSID);
 WINBASEAPI INT         WINAPI CompareFileTime(const FILETIME*,const FILETIME*);
+WINBASEAPI BOOL        WINAPI CompareObjectHandles(HANDLE,HANDLE);
 WINBASEAPI BOOL        WINAPI ConvertFiberToThread(void);
 WINBASEAPI LPVOID      WINAPI ConvertThreadToFiber(LPVOID);
 WINBASEAPI LPVOID      WINAPI ConvertThreadToFiberEx(LPVOID,DWORD);
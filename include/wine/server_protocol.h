@@ -53,11 +53,6 @@ struct request_max_size
 #define FIRST_USER_HANDLE 0x0020
 #define LAST_USER_HANDLE  0xffef
 
-typedef struct
-{
-    unsigned int last_input_time;
-} shmglobal_t;
-
 typedef struct
 {
     int             queue_bits;
@@ -264,6 +259,45 @@ typedef struct
 } rectangle_t;
 
 
+typedef struct
+{
+    user_handle_t   handle;
+    user_handle_t   parent;
+    user_handle_t   owner;
+    process_id_t    pid;
+    thread_id_t     tid;
+    unsigned int    style;
+    unsigned int    ex_style;
+    unsigned int    dpi;
+    rectangle_t     window;
+    rectangle_t     client;
+} shm_window_t;
+
+#define SHM_WINDOW_COUNT ((LAST_USER_HANDLE - FIRST_USER_HANDLE + 1) >> 1)
+
+typedef struct
+{
+    unsigned int last_input_time;
+    unsigned int window_seq;
+    shm_window_t windows[SHM_WINDOW_COUNT];
+} shmglobal_t;
+
+
+typedef struct
+{
+    unsigned int    seq;
+    unsigned int    access;
+    client_ptr_t    object;
+} shm_handle_t;
+
+#define SHM_HANDLE_COUNT 16384
+
+typedef struct
+{
+    shm_handle_t    handles[SHM_HANDLE_COUNT];
+} shmprocess_t;
+
+
 typedef struct
 {
     obj_handle_t    handle;
@@ -381,6 +415,19 @@ typedef union
 } message_data_t;
 
 
+typedef struct
+{
+    user_handle_t   win;
+    unsigned int    msg;
+    lparam_t        wparam;
+    lparam_t        lparam;
+    int             x;
+    int             y;
+    unsigned int    time;
+    int             __pad;
+} posted_message_t;
+
+
 typedef struct
 {
     WCHAR          ch;
@@ -1718,6 +1765,8 @@ struct get_shared_memory_request
 {
     struct request_header __header;
     thread_id_t tid;
+    int         process;
+    char __pad_20[4];
 };
 struct get_shared_memory_reply
 {
@@ -1726,6 +1775,20 @@ struct get_shared_memory_reply
 
 
 
+struct compare_objects_request
+{
+    struct request_header __header;
+    obj_handle_t first;
+    obj_handle_t second;
+    char __pad_20[4];
+};
+struct compare_objects_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct flush_request
 {
     struct request_header __header;
@@ -3356,6 +3419,8 @@ struct get_message_request
     unsigned int    hw_id;
     unsigned int    wake_mask;
     unsigned int    changed_mask;
+    unsigned int    prefetch;
+    char __pad_44[4];
 };
 struct get_message_reply
 {
@@ -3370,7 +3435,9 @@ struct get_message_reply
     unsigned int    time;
     unsigned int    active_hooks;
     data_size_t     total;
+    unsigned int    prefetched;
     /* VARARG(data,message_data); */
+    char __pad_60[4];
 };
 
 
@@ -6334,6 +6401,7 @@ enum request
     REQ_get_handle_fd,
     REQ_get_directory_cache_entry,
     REQ_get_shared_memory,
+    REQ_compare_objects,
     REQ_flush,
     REQ_get_file_info,
     REQ_get_volume_info,
@@ -6664,6 +6732,7 @@ union generic_request
     struct get_handle_fd_request get_handle_fd_request;
     struct get_directory_cache_entry_request get_directory_cache_entry_request;
     struct get_shared_memory_request get_shared_memory_request;
+    struct compare_objects_request compare_objects_request;
     struct flush_request flush_request;
     struct get_file_info_request get_file_info_request;
     struct get_volume_info_request get_volume_info_request;
@@ -6992,6 +7061,7 @@ union generic_reply
     struct get_handle_fd_reply get_handle_fd_reply;
     struct get_directory_cache_entry_reply get_directory_cache_entry_reply;
     struct get_shared_memory_reply get_shared_memory_reply;
+    struct compare_objects_reply compare_objects_reply;
     struct flush_reply flush_reply;
     struct get_file_info_reply get_file_info_reply;
     struct get_volume_info_reply get_volume_info_reply;
@@ -7265,7 +7335,7 @@ union generic_reply
 
 /* ### protocol_version begin ### */
 
-#define SERVER_PROTOCOL_VERSION 637
+#define SERVER_PROTOCOL_VERSION 640
 
 /* ### protocol_version end ### */
 
@@ -134,7 +134,11 @@ static struct object_type *object_type_get_type( struct object *obj )
 
 static void directory_dump( struct object *obj, int verbose )
 {
-    fputs( "Directory\n", stderr );
+    struct directory *dir = (struct directory *)obj;
+    assert( obj->ops == &directory_ops );
+
+    fputs( "Directory ", stderr );
+    dump_namespace( dir->entries );
 }
 
 static struct object_type *directory_get_type( struct object *obj )
@@ -202,7 +206,7 @@ static void directory_destroy( struct object *obj )
 {
     struct directory *dir = (struct directory *)obj;
     assert( obj->ops == &directory_ops );
-    free( dir->entries );
+    free_namespace( dir->entries );
 }
 
 static struct list *directory_get_kernel_obj_list( struct object *obj )
@@ -377,13 +377,24 @@ static file_pos_t max_unix_offset = OFF_T_MAX;
 
 struct timeout_user
 {
-    struct list           entry;      /* entry in sorted timeout list */
+    struct list           entry;      /* entry in expired timeout list */
+    unsigned int          index;      /* index in timeout heap, or EXPIRED_TIMEOUT */
+    unsigned int          seq;        /* insertion sequence number */
     timeout_t             when;       /* timeout expiry (absolute time) */
     timeout_callback      callback;   /* callback function */
     void                 *private;    /* callback private data */
 };
 
-static struct list timeout_list = LIST_INIT(timeout_list);   /* sorted timeouts list */
+#define EXPIRED_TIMEOUT (~0u)
+
+static struct mem_pool timeout_pool = MEM_POOL_INIT( "timeout", sizeof(struct timeout_user) );
+
+/* pending timeouts are kept in a binary heap ordered by expiry time; */
+/* timeouts with the same expiry are ordered by reverse insertion order */
+static struct timeout_user **timeout_heap;
+static unsigned int timeout_count;   /* number of pending timeouts */
+static unsigned int timeout_size;    /* allocated size of the heap */
+static unsigned int timeout_seq;     /* sequence number for the next timeout */
 timeout_t current_time;
 
 static inline void set_current_time(void)
@@ -394,33 +405,98 @@ static inline void set_current_time(void)
     current_time = (timeout_t)now.tv_sec * TICKS_PER_SEC + now.tv_usec * 10 + ticks_1601_to_1970;
 }
 
+/* check if a timeout expires before another one */
+static inline int timeout_before( const struct timeout_user *a, const struct timeout_user *b )
+{
+    if (a->when != b->when) return a->when < b->when;
+    return (int)(a->seq - b->seq) > 0;  /* most recently added first */
+}
+
+/* store a timeout at a given position in the heap */
+static inline void set_timeout_heap( unsigned int index, struct timeout_user *user )
+{
+    timeout_heap[index] = user;
+    user->index = index;
+}
+
+/* move a timeout up the heap to its rightful place */
+static void timeout_heap_up( unsigned int index, struct timeout_user *user )
+{
+    while (index)
+    {
+        unsigned int parent = (index - 1) / 2;
+        if (!timeout_before( user, timeout_heap[parent] )) break;
+        set_timeout_heap( index, timeout_heap[parent] );
+        index = parent;
+    }
+    set_timeout_heap( index, user );
+}
+
+/* move a timeout down the heap to its rightful place */
+static void timeout_heap_down( unsigned int index, struct timeout_user *user )
+{
+    unsigned int child;
+
+    while ((child = 2 * index + 1) < timeout_count)
+    {
+        if (child + 1 < timeout_count && timeout_before( timeout_heap[child + 1], timeout_heap[child] ))
+            child++;
+        if (!timeout_before( timeout_heap[child], user )) break;
+        set_timeout_heap( index, timeout_heap[child] );
+        index = child;
+    }
+    set_timeout_heap( index, user );
+}
+
+/* remove a timeout from the heap */
+static void timeout_heap_remove( struct timeout_user *user )
+{
+    unsigned int index = user->index;
+    struct timeout_user *last = timeout_heap[--timeout_count];
+
+    user->index = EXPIRED_TIMEOUT;
+    if (last == user) return;
+    if (index && timeout_before( last, timeout_heap[(index - 1) / 2] )) timeout_heap_up( index, last );
+    else timeout_heap_down( index, last );
+}
+
 /* add a timeout user */
 struct timeout_user *add_timeout_user( timeout_t when, timeout_callback func, void *private )
 {
     struct timeout_user *user;
-    struct list *ptr;
 
-    if (!(user = mem_alloc( sizeof(*user) ))) return NULL;
+    if (timeout_count == timeout_size)
+    {
+        unsigned int new_size = max( 64, timeout_size * 2 );
+        struct timeout_user **new_heap = realloc( timeout_heap, new_size * sizeof(*new_heap) );
+
+        if (!new_heap)
+        {
+            set_error( STATUS_NO_MEMORY );
+            return NULL;
+        }
+        timeout_heap = new_heap;
+        timeout_size = new_size;
+    }
+
+    if (!(user = pool_alloc( &timeout_pool ))) return NULL;
     user->when     = (when > 0) ? when : current_time - when;
+    user->seq      = timeout_seq++;
     user->callback = func;
     user->private  = private;
 
-    /* Now insert it in the linked list */
+    /* Now insert it in the heap */
 
-    LIST_FOR_EACH( ptr, &timeout_list )
-    {
-        struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-        if (timeout->when >= user->when) break;
-    }
-    list_add_before( ptr, &user->entry );
+    timeout_heap_up( timeout_count++, user );
     return user;
 }
 
 /* remove a timeout user */
 void remove_timeout_user( struct timeout_user *user )
 {
-    list_remove( &user->entry );
-    free( user );
+    if (user->index == EXPIRED_TIMEOUT) list_remove( &user->entry );
+    else timeout_heap_remove( user );
+    pool_free( &timeout_pool, user );
 }
 
 /* return a text description of a timeout for debugging purposes */
@@ -865,23 +941,19 @@ static void remove_poll_user( struct fd *fd, int user )
 /* process pending timeouts and return the time until the next timeout, in milliseconds */
 static int get_next_timeout(void)
 {
-    if (!list_empty( &timeout_list ))
+    if (timeout_count)
     {
         struct list expired_list, *ptr;
 
-        /* first remove all expired timers from the list */
+        /* first remove all expired timers from the heap */
 
         list_init( &expired_list );
-        while ((ptr = list_head( &timeout_list )) != NULL)
+        while (timeout_count && timeout_heap[0]->when <= current_time)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
+            struct timeout_user *timeout = timeout_heap[0];
 
-            if (timeout->when <= current_time)
-            {
-                list_remove( &timeout->entry );
-                list_add_tail( &expired_list, &timeout->entry );
-            }
-            else break;
+            timeout_heap_remove( timeout );
+            list_add_tail( &expired_list, &timeout->entry );
         }
 
         /* now call the callback for all the removed timers */
@@ -891,12 +963,12 @@ static int get_next_timeout(void)
             struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
             list_remove( &timeout->entry );
             timeout->callback( timeout->private );
-            free( timeout );
+            pool_free( &timeout_pool, timeout );
         }
 
-        if ((ptr = list_head( &timeout_list )) != NULL)
+        if (timeout_count)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
+            struct timeout_user *timeout = timeout_heap[0];
             int diff = (timeout->when - current_time + 9999) / 10000;
             if (diff < 0) diff = 0;
             return diff;
@@ -2797,7 +2869,23 @@ DECL_HANDLER(write)
 /* get file descriptor to shared memory block */
 DECL_HANDLER(get_shared_memory)
 {
-    if (req->tid)
+    if (req->process)
+    {
+        struct process *process = current->process;
+
+        /* handles of kernel processes may refer to the client process table */
+        if (process->is_kernel)
+            set_error( STATUS_NOT_SUPPORTED );
+        else if (process->shm_fd != -1 || allocate_shared_memory( &process->shm_fd,
+                 (void **)&process->shm, sizeof(*process->shm) ))
+        {
+            publish_process_handles( process );
+            send_client_fd( process, process->shm_fd, 0 );
+        }
+        else
+            set_error( STATUS_NOT_SUPPORTED );
+    }
+    else if (req->tid)
     {
         struct thread *thread = get_thread_from_id( req->tid );
         if (thread)
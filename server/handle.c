@@ -98,6 +98,22 @@ static inline obj_handle_t handle_global_to_local( obj_handle_t handle )
     return handle ^ HANDLE_OBFUSCATOR;
 }
 
+/* publish a handle entry in the shared memory of the owning process */
+static void update_shm_handle( struct handle_table *table, struct handle_entry *entry )
+{
+    unsigned int index = entry - table->entries;
+    shm_handle_t *shm_handle;
+
+    if (!table->process || !table->process->shm || index >= SHM_HANDLE_COUNT) return;
+    shm_handle = &table->process->shm->handles[index];
+
+    /* readers retry while the sequence counter is odd or has changed */
+    interlocked_xchg_add( (int *)&shm_handle->seq, 1 );
+    shm_handle->access = entry->ptr ? entry->access & ~RESERVED_ALL : 0;
+    shm_handle->object = entry->ptr ? (client_ptr_t)(unsigned long)entry->ptr : 0;
+    interlocked_xchg_add( (int *)&shm_handle->seq, 1 );
+}
+
 /* grab an object and increment its handle count */
 static struct object *grab_object_for_handle( struct object *obj )
 {
@@ -201,6 +217,17 @@ void close_process_handles( struct process *process )
     if (table) release_object( table );
 }
 
+/* publish all the handles of a process in its shared memory */
+void publish_process_handles( struct process *process )
+{
+    struct handle_table *table = process->handles;
+    int i;
+
+    if (!table) return;
+    for (i = 0; i <= table->last && i < SHM_HANDLE_COUNT; i++)
+        update_shm_handle( table, table->entries + i );
+}
+
 /* allocate a new handle table */
 struct handle_table *alloc_handle_table( struct process *process, int count )
 {
@@ -252,6 +279,7 @@ static obj_handle_t alloc_entry( struct handle_table *table, struct object *obj,
     table->free = i + 1;
     entry->ptr    = grab_object_for_handle( obj );
     entry->access = access;
+    update_shm_handle( table, entry );
 
     if (table->process)
         obj->ops->alloc_handle( obj, table->process, index_to_handle(i) );
@@ -485,6 +513,7 @@ unsigned int close_handle( struct process *process, obj_handle_t handle )
     if (!obj->ops->close_handle( obj, process, handle )) return STATUS_HANDLE_NOT_CLOSABLE;
     entry->ptr = NULL;
     table = handle_is_global(handle) ? global_table : process->handles;
+    update_shm_handle( table, entry );
     if (entry < table->entries + table->free) table->free = entry - table->entries;
     if (entry == table->entries + table->last) shrink_handle_table( table );
     release_object_from_handle( obj );
@@ -660,6 +689,7 @@ obj_handle_t duplicate_handle( struct process *src, obj_handle_t src_handle, str
         {
             if (attr & OBJ_INHERIT) access |= RESERVED_INHERIT;
             entry->access = access;
+            update_shm_handle( handle_is_global(src_handle) ? global_table : src->handles, entry );
             res = src_handle;
         }
         else
@@ -969,3 +999,17 @@ DECL_HANDLER(get_system_handles)
         enum_processes( enum_handles, &info );
     }
 }
+
+/* check if two handles refer to the same object */
+DECL_HANDLER(compare_objects)
+{
+    struct object *first, *second;
+
+    if (!(first = get_handle_obj( current->process, req->first, 0, NULL ))) return;
+    if ((second = get_handle_obj( current->process, req->second, 0, NULL )))
+    {
+        if (first != second) set_error( STATUS_NOT_SAME_OBJECT );
+        release_object( second );
+    }
+    release_object( first );
+}
@@ -51,6 +51,7 @@ extern obj_handle_t find_inherited_handle( struct process *process, const struct
 extern obj_handle_t enumerate_handles( struct process *process, const struct object_ops *ops,
                                        unsigned int *index, struct object **obj );
 extern void close_process_handles( struct process *process );
+extern void publish_process_handles( struct process *process );
 extern struct handle_table *alloc_handle_table( struct process *process, int count );
 extern struct handle_table *copy_handle_table( struct process *process, struct process *parent );
 extern unsigned int get_handle_table_count( struct process *process);
@@ -460,7 +460,11 @@ static void pipe_server_destroy( struct object *obj )
 
 static void named_pipe_device_dump( struct object *obj, int verbose )
 {
-    fputs( "Named pipe device\n", stderr );
+    struct named_pipe_device *device = (struct named_pipe_device *)obj;
+    assert( obj->ops == &named_pipe_device_ops );
+
+    fputs( "Named pipe device ", stderr );
+    dump_namespace( device->pipes );
 }
 
 static struct object_type *named_pipe_device_get_type( struct object *obj )
@@ -506,7 +510,7 @@ static void named_pipe_device_destroy( struct object *obj )
 {
     struct named_pipe_device *device = (struct named_pipe_device*)obj;
     assert( obj->ops == &named_pipe_device_ops );
-    free( device->pipes );
+    free_namespace( device->pipes );
 }
 
 struct object *create_named_pipe_device( struct object *root, const struct unicode_str *name )
@@ -46,9 +46,19 @@
 struct namespace
 {
     unsigned int        hash_size;       /* size of hash table */
-    struct list         names[1];        /* array of hash entry lists */
+    unsigned int        count;           /* number of names in the namespace */
+    unsigned int        grow_count;      /* number of times the hash table has grown */
+    struct list        *names;           /* array of hash entry lists */
+    struct list        *old_names;       /* previous hash table while it is being migrated */
+    unsigned int        old_size;        /* size of the previous hash table */
+    unsigned int        old_pos;         /* next bucket of the previous hash table to migrate */
+    struct list         buckets[1];      /* initial hash table */
 };
 
+#define NAMESPACE_MAX_LOAD      4        /* average chain length that triggers a rehash */
+#define NAMESPACE_MAX_SIZE      0x100000 /* maximum number of hash buckets */
+#define NAMESPACE_MIGRATE_STEP  8        /* buckets migrated on each insertion */
+
 
 #ifdef DEBUG_OBJECTS
 static struct list object_list = LIST_INIT(object_list);
@@ -127,11 +137,148 @@ void *memdup( const void *data, size_t len )
 
 /*****************************************************************/
 
+#define POOL_CHUNK_SIZE          16384   /* size of the chunks allocated for pools */
+#define POOL_ALIGNMENT           16      /* alignment of the blocks, same as malloc */
+#define OBJECT_POOL_GRANULARITY  16      /* size difference between object pools */
+#define OBJECT_POOL_MAX_SIZE     512     /* larger objects are allocated with malloc */
+
+static struct list pool_list = LIST_INIT(pool_list);
+static struct mem_pool object_pools[OBJECT_POOL_MAX_SIZE / OBJECT_POOL_GRANULARITY];
+
+/* allocate a new chunk of blocks for a pool */
+static int grow_pool( struct mem_pool *pool )
+{
+    size_t size = (pool->size + POOL_ALIGNMENT - 1) & ~(POOL_ALIGNMENT - 1);
+    unsigned int i, count = max( 1, POOL_CHUNK_SIZE / size );
+    char *chunk;
+
+    /* chunks are never freed, the blocks are recycled through the free list */
+    if (!(chunk = malloc( count * size ))) return 0;
+    if (!pool->total) list_add_tail( &pool_list, &pool->entry );
+    for (i = 0; i < count; i++)
+    {
+        void **block = (void **)(chunk + i * size);
+        *block = pool->free_list;
+        pool->free_list = block;
+    }
+    pool->total += count;
+    return 1;
+}
+
+/* allocate a block from a memory pool */
+void *pool_alloc( struct mem_pool *pool )
+{
+    void **block;
+
+    if (!pool->free_list && !grow_pool( pool ))
+    {
+        set_error( STATUS_NO_MEMORY );
+        return NULL;
+    }
+    block = pool->free_list;
+    pool->free_list = *block;
+    if (++pool->used > pool->peak) pool->peak = pool->used;
+    pool->allocs++;
+    mark_block_uninitialized( block, pool->size );
+    return block;
+}
+
+/* return a block to its memory pool */
+void pool_free( struct mem_pool *pool, void *ptr )
+{
+    void **block = ptr;
+
+    if (!block) return;
+    assert( pool->used );
+    pool->used--;
+    *block = pool->free_list;
+    pool->free_list = block;
+}
+
+/* dump the usage statistics of the memory pools to stderr */
+void dump_pools(void)
+{
+    struct mem_pool *pool;
+
+    LIST_FOR_EACH_ENTRY( pool, &pool_list, struct mem_pool, entry )
+        fprintf( stderr, "Pool %s size=%u total=%u used=%u peak=%u allocs=%u\n",
+                 pool->name, (unsigned int)pool->size, pool->total, pool->used, pool->peak, pool->allocs );
+}
+
+/* get the pool used for objects of a given size */
+static struct mem_pool *get_object_pool( size_t size )
+{
+    struct mem_pool *pool;
+
+    if (!size || size > OBJECT_POOL_MAX_SIZE) return NULL;
+    pool = &object_pools[(size - 1) / OBJECT_POOL_GRANULARITY];
+    if (!pool->size)
+    {
+        pool->name = "object";
+        pool->size = (pool - object_pools + 1) * OBJECT_POOL_GRANULARITY;
+    }
+    return pool;
+}
+
+/*****************************************************************/
+
+/* move a few buckets of the previous hash table to the current one */
+static void migrate_names( struct namespace *namespace, unsigned int count )
+{
+    struct object_name *ptr;
+    struct list *bucket, *entry;
+
+    while (count-- && namespace->old_pos < namespace->old_size)
+    {
+        bucket = &namespace->old_names[namespace->old_pos++];
+        while ((entry = list_head( bucket )))
+        {
+            ptr = LIST_ENTRY( entry, struct object_name, entry );
+            list_remove( &ptr->entry );
+            /* older names go after the ones added since the rehash started */
+            list_add_tail( &namespace->names[hash_strW( ptr->name, ptr->len, namespace->hash_size )],
+                           &ptr->entry );
+        }
+    }
+    if (namespace->old_pos < namespace->old_size) return;
+
+    if (namespace->old_names != namespace->buckets) free( namespace->old_names );
+    namespace->old_names = NULL;
+    namespace->old_size  = 0;
+    namespace->old_pos   = 0;
+}
+
+/* start migrating the names to a larger hash table */
+static void grow_namespace( struct namespace *namespace )
+{
+    unsigned int i, new_size = namespace->hash_size * 2 + 1;
+    struct list *names;
+
+    if (new_size > NAMESPACE_MAX_SIZE) return;
+    if (!(names = malloc( new_size * sizeof(*names) ))) return;  /* keep using the current table */
+    for (i = 0; i < new_size; i++) list_init( &names[i] );
+
+    namespace->old_names = namespace->names;
+    namespace->old_size  = namespace->hash_size;
+    namespace->old_pos   = 0;
+    namespace->names     = names;
+    namespace->hash_size = new_size;
+    namespace->grow_count++;
+}
+
 void namespace_add( struct namespace *namespace, struct object_name *ptr )
 {
-    unsigned int hash = hash_strW( ptr->name, ptr->len, namespace->hash_size );
+    unsigned int hash;
+
+    if (!namespace->old_names && namespace->count >= namespace->hash_size * NAMESPACE_MAX_LOAD)
+        grow_namespace( namespace );
 
+    hash = hash_strW( ptr->name, ptr->len, namespace->hash_size );
     list_add_head( &namespace->names[hash], &ptr->entry );
+    ptr->namespace = namespace;
+    namespace->count++;
+
+    if (namespace->old_names) migrate_names( namespace, NAMESPACE_MIGRATE_STEP );
 }
 
 /* allocate a name for an object */
@@ -143,6 +290,7 @@ static struct object_name *alloc_name( const struct unicode_str *name )
     {
         ptr->len = name->len;
         ptr->parent = NULL;
+        ptr->namespace = NULL;
         memcpy( ptr->name, name->str, name->len );
     }
     return ptr;
@@ -189,7 +337,8 @@ WCHAR *get_object_full_name( struct object *obj, data_size_t *ret_len )
 /* allocate and initialize an object */
 void *alloc_object( const struct object_ops *ops )
 {
-    struct object *obj = mem_alloc( ops->size );
+    struct mem_pool *pool = get_object_pool( ops->size );
+    struct object *obj = pool ? pool_alloc( pool ) : mem_alloc( ops->size );
     if (obj)
     {
         obj->refcount     = 1;
@@ -214,7 +363,8 @@ static void free_object( struct object *obj )
     list_remove( &obj->obj_list );
     memset( obj, 0xaa, obj->ops->size );
 #endif
-    free( obj );
+    if (obj->ops->size <= OBJECT_POOL_MAX_SIZE) pool_free( get_object_pool( obj->ops->size ), obj );
+    else free( obj );
 }
 
 /* find an object by name starting from the specified root */
@@ -433,48 +583,75 @@ void release_object( void *ptr )
     }
 }
 
-/* find an object by its name; the refcount is incremented */
-struct object *find_object( const struct namespace *namespace, const struct unicode_str *name,
-                            unsigned int attributes )
+/* find a name in a hash bucket */
+static struct object_name *find_name_in_list( const struct list *list, const struct unicode_str *name,
+                                              unsigned int attributes )
 {
-    const struct list *list;
-    struct list *p;
-
-    if (!name || !name->len) return NULL;
+    struct object_name *ptr;
 
-    list = &namespace->names[ hash_strW( name->str, name->len, namespace->hash_size ) ];
-    LIST_FOR_EACH( p, list )
+    LIST_FOR_EACH_ENTRY( ptr, list, struct object_name, entry )
     {
-        const struct object_name *ptr = LIST_ENTRY( p, struct object_name, entry );
         if (ptr->len != name->len) continue;
         if (attributes & OBJ_CASE_INSENSITIVE)
         {
-            if (!memicmp_strW( ptr->name, name->str, name->len ))
-                return grab_object( ptr->obj );
+            if (!memicmp_strW( ptr->name, name->str, name->len )) return ptr;
         }
         else
         {
-            if (!memcmp( ptr->name, name->str, name->len ))
-                return grab_object( ptr->obj );
+            if (!memcmp( ptr->name, name->str, name->len )) return ptr;
         }
     }
     return NULL;
 }
 
+/* find an object by its name; the refcount is incremented */
+struct object *find_object( const struct namespace *namespace, const struct unicode_str *name,
+                            unsigned int attributes )
+{
+    struct object_name *ptr;
+
+    if (!name || !name->len) return NULL;
+
+    if ((ptr = find_name_in_list( &namespace->names[hash_strW( name->str, name->len, namespace->hash_size )],
+                                  name, attributes )))
+        return grab_object( ptr->obj );
+
+    /* names that have not been migrated yet are still in the previous table */
+    if (namespace->old_names &&
+        (ptr = find_name_in_list( &namespace->old_names[hash_strW( name->str, name->len, namespace->old_size )],
+                                  name, attributes )))
+        return grab_object( ptr->obj );
+
+    return NULL;
+}
+
 /* find an object by its index; the refcount is incremented */
 struct object *find_object_index( const struct namespace *namespace, unsigned int index )
 {
+    const struct object_name *ptr;
     unsigned int i;
 
+    if (index >= namespace->count)
+    {
+        set_error( STATUS_NO_MORE_ENTRIES );
+        return NULL;
+    }
+
     /* FIXME: not efficient at all */
     for (i = 0; i < namespace->hash_size; i++)
     {
-        const struct object_name *ptr;
         LIST_FOR_EACH_ENTRY( ptr, &namespace->names[i], const struct object_name, entry )
         {
             if (!index--) return grab_object( ptr->obj );
         }
     }
+    for (i = namespace->old_pos; i < namespace->old_size; i++)
+    {
+        LIST_FOR_EACH_ENTRY( ptr, &namespace->old_names[i], const struct object_name, entry )
+        {
+            if (!index--) return grab_object( ptr->obj );
+        }
+    }
     set_error( STATUS_NO_MORE_ENTRIES );
     return NULL;
 }
@@ -485,15 +662,55 @@ struct namespace *create_namespace( unsigned int hash_size )
     struct namespace *namespace;
     unsigned int i;
 
-    namespace = mem_alloc( sizeof(*namespace) + (hash_size - 1) * sizeof(namespace->names[0]) );
+    namespace = mem_alloc( sizeof(*namespace) + (hash_size - 1) * sizeof(namespace->buckets[0]) );
     if (namespace)
     {
         namespace->hash_size      = hash_size;
+        namespace->count          = 0;
+        namespace->grow_count     = 0;
+        namespace->names          = namespace->buckets;
+        namespace->old_names      = NULL;
+        namespace->old_size       = 0;
+        namespace->old_pos        = 0;
         for (i = 0; i < hash_size; i++) list_init( &namespace->names[i] );
     }
     return namespace;
 }
 
+/* free a namespace; the names it contains are not freed */
+void free_namespace( struct namespace *namespace )
+{
+    if (!namespace) return;
+    if (namespace->names != namespace->buckets) free( namespace->names );
+    if (namespace->old_names && namespace->old_names != namespace->buckets) free( namespace->old_names );
+    free( namespace );
+}
+
+/* dump the occupancy of a namespace to stderr */
+void dump_namespace( const struct namespace *namespace )
+{
+    unsigned int i, len, used = 0, longest = 0;
+    struct list *p;
+
+    if (!namespace)
+    {
+        fputc( '\n', stderr );
+        return;
+    }
+    for (i = 0; i < namespace->hash_size; i++)
+    {
+        len = 0;
+        LIST_FOR_EACH( p, &namespace->names[i] ) len++;
+        if (len) used++;
+        if (len > longest) longest = len;
+    }
+    fprintf( stderr, "names=%u buckets=%u used=%u longest=%u grown=%u",
+             namespace->count, namespace->hash_size, used, longest, namespace->grow_count );
+    if (namespace->old_names)
+        fprintf( stderr, " migrating=%u/%u", namespace->old_pos, namespace->old_size );
+    fputc( '\n', stderr );
+}
+
 /* functions for unimplemented/default object operations */
 
 struct object_type *no_get_type( struct object *obj )
@@ -700,6 +917,7 @@ int no_link_name( struct object *obj, struct object_name *name, struct object *p
 void default_unlink_name( struct object *obj, struct object_name *name )
 {
     list_remove( &name->entry );
+    if (name->namespace) name->namespace->count--;
 }
 
 struct object *no_open_file( struct object *obj, unsigned int access, unsigned int sharing,
@@ -119,6 +119,7 @@ struct object_name
     struct list         entry;           /* entry in the hash list */
     struct object      *obj;             /* object owning this name */
     struct object      *parent;          /* parent object */
+    struct namespace   *namespace;       /* namespace holding the name, if any */
     data_size_t         len;             /* name length in bytes */
     WCHAR               name[1];
 };
@@ -130,8 +131,26 @@ struct wait_queue_entry
     struct thread_wait *wait;
 };
 
+/* memory pool for frequently allocated fixed-size blocks */
+struct mem_pool
+{
+    const char         *name;            /* pool name for the statistics */
+    size_t              size;            /* size of the blocks */
+    void               *free_list;       /* list of free blocks */
+    struct list         entry;           /* entry in the list of pools */
+    unsigned int        total;           /* number of blocks allocated from the system */
+    unsigned int        used;            /* number of blocks in use */
+    unsigned int        peak;            /* highest number of blocks in use */
+    unsigned int        allocs;          /* number of allocations */
+};
+
+#define MEM_POOL_INIT(name,size) { name, size, NULL, { NULL, NULL }, 0, 0, 0, 0 }
+
 extern void *mem_alloc( size_t size );  /* malloc wrapper */
 extern void *memdup( const void *data, size_t len );
+extern void *pool_alloc( struct mem_pool *pool );
+extern void pool_free( struct mem_pool *pool, void *ptr );
+extern void dump_pools(void);
 extern void *alloc_object( const struct object_ops *ops );
 extern void namespace_add( struct namespace *namespace, struct object_name *ptr );
 extern const WCHAR *get_object_name( struct object *obj, data_size_t *len );
@@ -148,6 +167,8 @@ extern void *open_named_object( struct object *parent, const struct object_ops *
 extern void unlink_named_object( struct object *obj );
 extern void make_object_static( struct object *obj );
 extern struct namespace *create_namespace( unsigned int hash_size );
+extern void free_namespace( struct namespace *namespace );
+extern void dump_namespace( const struct namespace *namespace );
 extern void free_kernel_objects( struct object *obj );
 /* grab/release_object can take any pointer, but you better make sure */
 /* that the thing pointed to starts with a struct object... */
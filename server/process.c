@@ -547,6 +547,8 @@ struct process *create_process( int fd, struct process *parent, int inherit_all,
     process->dev_mgr         = NULL;
     process->callback_init_event = NULL;
     process->esync_fd        = -1;
+    process->shm_fd          = -1;
+    process->shm             = NULL;
     list_init( &process->kernel_object );
     list_init( &process->thread_list );
     list_init( &process->locks );
@@ -650,6 +652,7 @@ static void process_destroy( struct object *obj )
     if (process->token) release_object( process->token );
     if (process->callback_init_event) release_object( process->callback_init_event );
     free( process->dir_cache );
+    release_shared_memory( process->shm_fd, process->shm, sizeof(*process->shm) );
 
     if (do_esync())
         close( process->esync_fd );
@@ -102,6 +102,8 @@ struct process
     struct object        *callback_init_event;
     struct device_manager *dev_mgr;
     int                  esync_fd;        /* esync file descriptor (signaled on exit) */
+    int                  shm_fd;          /* file descriptor for process shared memory */
+    shmprocess_t        *shm;             /* process shared memory pointer */
 };
 
 struct process_snapshot
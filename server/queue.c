@@ -36,6 +36,7 @@
 #include "wingdi.h"
 #include "winuser.h"
 #include "winternl.h"
+#include "dde.h"
 
 #include "handle.h"
 #include "file.h"
@@ -87,9 +88,14 @@ struct message
     struct message_result *result;    /* result in sender queue */
 };
 
+static struct mem_pool message_pool = MEM_POOL_INIT( "message", sizeof(struct message) );
+
 struct timer
 {
     struct list     entry;     /* entry in timer list */
+    struct list     hash_entry; /* entry in timer hash table */
+    struct msg_queue *queue;   /* queue owning the timer */
+    struct timeout_user *timeout; /* timeout for next expiration while pending */
     timeout_t       when;      /* next expiration */
     unsigned int    rate;      /* timer rate in ms */
     user_handle_t   win;       /* window handle */
@@ -144,7 +150,6 @@ struct msg_queue
     struct list            pending_timers;  /* list of pending timers */
     struct list            expired_timers;  /* list of expired timers */
     lparam_t               next_timer_id;   /* id for the next timer with a 0 window */
-    struct timeout_user   *timeout;         /* timeout for next timer to expire */
     struct thread_input   *input;           /* thread input descriptor */
     struct list            input_entry;     /* entry in input->queues */
     struct hook_table     *hooks;           /* hook table */
@@ -336,7 +341,6 @@ static struct msg_queue *create_msg_queue( struct thread *thread, struct thread_
         queue->cursor_count    = 0;
         queue->recv_result     = NULL;
         queue->next_timer_id   = 0x7fff;
-        queue->timeout         = NULL;
         queue->input           = (struct thread_input *)grab_object( input );
         list_add_tail( &input->queues, &queue->input_entry );
         queue->hooks           = NULL;
@@ -403,10 +407,10 @@ static struct message *alloc_hardware_message( lparam_t info, struct hw_msg_sour
     struct hardware_msg_data *msg_data;
     struct message *msg;
 
-    if (!(msg = mem_alloc( sizeof(*msg) ))) return NULL;
+    if (!(msg = pool_alloc( &message_pool ))) return NULL;
     if (!(msg_data = mem_alloc( sizeof(*msg_data) + extra_len )))
     {
-        free( msg );
+        pool_free( &message_pool, msg );
         return NULL;
     }
     memset( msg, 0, sizeof(*msg) );
@@ -613,12 +617,66 @@ static inline unsigned int get_unique_post_id(void)
     return id;
 }
 
+/* check if relative rawinput mouse motion should be coalesced */
+static int do_rawinput_coalesce(void)
+{
+    static int do_rawinput_coalesce_cached = -1;
+
+    if (do_rawinput_coalesce_cached == -1)
+        do_rawinput_coalesce_cached = getenv("WINERAWINPUTCOALESCE") && atoi(getenv("WINERAWINPUTCOALESCE"));
+
+    return do_rawinput_coalesce_cached;
+}
+
+/* check if a message is a rawinput mouse event carrying only relative motion */
+static int is_rawinput_motion( const struct message *msg )
+{
+    const struct hardware_msg_data *msg_data = msg->data;
+
+    if (msg->msg != WM_INPUT || msg->type != MSG_HARDWARE || !msg_data) return 0;
+    return msg_data->rawinput.type == RIM_TYPEMOUSE && msg_data->flags == MOUSEEVENTF_MOVE;
+}
+
+/* try to add the motion of a rawinput message to the last pending one; return 1 if successful */
+static int merge_rawinput_message( struct thread_input *input, const struct message *msg )
+{
+    struct hardware_msg_data *prev_data, *msg_data = msg->data;
+    struct message *prev;
+    struct list *ptr;
+
+    if (!do_rawinput_coalesce() || !is_rawinput_motion( msg )) return 0;
+
+    /* legacy mouse moves only carry the cursor position, any other message
+     * (button or wheel events in particular) keeps its order */
+    for (ptr = list_tail( &input->msg_list ); ptr; ptr = list_prev( &input->msg_list, ptr ))
+    {
+        prev = LIST_ENTRY( ptr, struct message, entry );
+        if (prev->msg != WM_MOUSEMOVE) break;
+    }
+    if (!ptr) return 0;
+    if (!is_rawinput_motion( prev )) return 0;
+    if (prev->unique_id) return 0;  /* already returned to the application */
+    if (prev->win != msg->win || prev->wparam != msg->wparam) return 0;
+
+    prev_data = prev->data;
+    if (prev_data->info != msg_data->info) return 0;
+    if (prev_data->source.device != msg_data->source.device ||
+        prev_data->source.origin != msg_data->source.origin) return 0;
+
+    /* now we can merge it */
+    prev_data->rawinput.mouse.x += msg_data->rawinput.mouse.x;
+    prev_data->rawinput.mouse.y += msg_data->rawinput.mouse.y;
+    prev->time = msg->time;
+    return 1;
+}
+
 /* try to merge a message with the last in the list; return 1 if successful */
 static int merge_message( struct thread_input *input, const struct message *msg )
 {
     struct message *prev;
     struct list *ptr;
 
+    if (msg->msg == WM_INPUT) return merge_rawinput_message( input, msg );
     if (msg->msg != WM_MOUSEMOVE) return 0;
     for (ptr = list_tail( &input->msg_list ); ptr; ptr = list_prev( &input->msg_list, ptr ))
     {
@@ -723,7 +781,7 @@ static void free_message( struct message *msg )
         store_message_result( result, 0, STATUS_ACCESS_DENIED /*FIXME*/ );
     }
     free( msg->data );
-    free( msg );
+    pool_free( &message_pool, msg );
 }
 
 /* remove (and free) a message from a message list */
@@ -788,7 +846,7 @@ static struct message_result *alloc_message_result( struct msg_queue *send_queue
 
         if (msg->type == MSG_CALLBACK)
         {
-            struct message *callback_msg = mem_alloc( sizeof(*callback_msg) );
+            struct message *callback_msg = pool_alloc( &message_pool );
 
             if (!callback_msg)
             {
@@ -854,7 +912,7 @@ static void receive_message( struct msg_queue *queue, struct message *msg,
         result->recv_next  = queue->recv_result;
         queue->recv_result = result;
     }
-    free( msg );
+    pool_free( &message_pool, msg );
     if (list_empty( &queue->msg_list[SEND_MESSAGE] )) clear_queue_bits( queue, QS_SENDMESSAGE );
 }
 
@@ -938,6 +996,53 @@ found:
     return 1;
 }
 
+/* check whether a posted message can be returned to the client ahead of time */
+static inline int is_prefetchable_message( const struct message *msg )
+{
+    if (msg->type != MSG_POSTED || msg->data_size) return 0;
+    if (msg->msg & 0x80000000) return 0;  /* internal message */
+    if (msg->msg == WM_HOTKEY) return 0;
+    return msg->msg < WM_DDE_FIRST || msg->msg > WM_DDE_LAST;
+}
+
+/* return the following posted messages along with the current one, they are */
+/* removed from the queue and kept by the client until it retrieves them */
+static void prefetch_posted_messages( struct msg_queue *queue, const struct get_message_request *req,
+                                      struct get_message_reply *reply )
+{
+    posted_message_t *data;
+    struct message *msg;
+    unsigned int i, count = 0, max;
+
+    /* without any filter, the prefetched messages are always the oldest ones */
+    if (!(req->flags & PM_REMOVE) || req->get_win || req->get_first || req->get_last != ~0U) return;
+    if (queue->ignore_post_msg || reply->type != MSG_POSTED || reply->total) return;
+    if (reply->msg & 0x80000000) return;
+
+    max = min( req->prefetch, get_reply_max_size() / sizeof(*data) );
+    LIST_FOR_EACH_ENTRY( msg, &queue->msg_list[POST_MESSAGE], struct message, entry )
+    {
+        if (count >= max || !is_prefetchable_message( msg )) break;
+        count++;
+    }
+    if (!count || !(data = set_reply_data_size( count * sizeof(*data) ))) return;
+
+    for (i = 0; i < count; i++)
+    {
+        msg = LIST_ENTRY( list_head( &queue->msg_list[POST_MESSAGE] ), struct message, entry );
+        data[i].win    = msg->win;
+        data[i].msg    = msg->msg;
+        data[i].wparam = msg->wparam;
+        data[i].lparam = msg->lparam;
+        data[i].x      = msg->x;
+        data[i].y      = msg->y;
+        data[i].time   = msg->time;
+        data[i].__pad  = 0;
+        remove_queue_message( queue, msg, POST_MESSAGE );
+    }
+    reply->prefetched = count;
+}
+
 static int get_quit_message( struct msg_queue *queue, unsigned int flags,
                              struct get_message_reply *reply )
 {
@@ -1104,16 +1209,18 @@ static void msg_queue_destroy( struct object *obj )
     while ((ptr = list_head( &queue->pending_timers )))
     {
         struct timer *timer = LIST_ENTRY( ptr, struct timer, entry );
+        if (timer->timeout) remove_timeout_user( timer->timeout );
         list_remove( &timer->entry );
+        list_remove( &timer->hash_entry );
         free( timer );
     }
     while ((ptr = list_head( &queue->expired_timers )))
     {
         struct timer *timer = LIST_ENTRY( ptr, struct timer, entry );
         list_remove( &timer->entry );
+        list_remove( &timer->hash_entry );
         free( timer );
     }
-    if (queue->timeout) remove_timeout_user( queue->timeout );
     if (queue->keystate_locked) queue->input->lock_count--;
     queue->input->cursor_count -= queue->cursor_count;
     list_remove( &queue->input_entry );
@@ -1262,82 +1369,69 @@ void detach_thread_input( struct thread *thread_from )
 }
 
 
-/* set the next timer to expire */
-static void set_next_timer( struct msg_queue *queue )
+/* set/clear the QS_TIMER bit according to the expired timers */
+static void update_timer_bits( struct msg_queue *queue )
 {
-    struct list *ptr;
-
-    if (queue->timeout)
-    {
-        remove_timeout_user( queue->timeout );
-        queue->timeout = NULL;
-    }
-    if ((ptr = list_head( &queue->pending_timers )))
-    {
-        struct timer *timer = LIST_ENTRY( ptr, struct timer, entry );
-        queue->timeout = add_timeout_user( timer->when, timer_callback, queue );
-    }
-    /* set/clear QS_TIMER bit */
     if (list_empty( &queue->expired_timers ))
         clear_queue_bits( queue, QS_TIMER );
     else
         set_queue_bits( queue, QS_TIMER );
 }
 
+/* get the hash table bucket of a timer */
+static struct list *get_timer_bucket( struct msg_queue *queue, user_handle_t win,
+                                      unsigned int msg, lparam_t id )
+{
+    static struct list timer_hash[4096];
+    unsigned int hash = ((unsigned int)id * 31 + win) * 31 + msg;
+    struct list *bucket;
+
+    hash ^= (unsigned int)((unsigned long)queue >> 6);
+    bucket = &timer_hash[hash % ARRAY_SIZE(timer_hash)];
+    if (!bucket->next) list_init( bucket );
+    return bucket;
+}
+
 /* find a timer from its window and id */
 static struct timer *find_timer( struct msg_queue *queue, user_handle_t win,
                                  unsigned int msg, lparam_t id )
 {
-    struct list *ptr;
-
-    /* we need to search both lists */
+    struct timer *timer;
 
-    LIST_FOR_EACH( ptr, &queue->pending_timers )
+    LIST_FOR_EACH_ENTRY( timer, get_timer_bucket( queue, win, msg, id ), struct timer, hash_entry )
     {
-        struct timer *timer = LIST_ENTRY( ptr, struct timer, entry );
-        if (timer->win == win && timer->msg == msg && timer->id == id) return timer;
-    }
-    LIST_FOR_EACH( ptr, &queue->expired_timers )
-    {
-        struct timer *timer = LIST_ENTRY( ptr, struct timer, entry );
-        if (timer->win == win && timer->msg == msg && timer->id == id) return timer;
+        if (timer->queue == queue && timer->win == win && timer->msg == msg && timer->id == id)
+            return timer;
     }
     return NULL;
 }
 
-/* callback for the next timer expiration */
+/* callback for a timer expiration */
 static void timer_callback( void *private )
 {
-    struct msg_queue *queue = private;
-    struct list *ptr;
+    struct timer *timer = private;
 
-    queue->timeout = NULL;
-    /* move on to the next timer */
-    ptr = list_head( &queue->pending_timers );
-    list_remove( ptr );
-    list_add_tail( &queue->expired_timers, ptr );
-    set_next_timer( queue );
+    timer->timeout = NULL;
+    list_remove( &timer->entry );
+    list_add_tail( &timer->queue->expired_timers, &timer->entry );
+    update_timer_bits( timer->queue );
 }
 
-/* link a timer at its rightful place in the queue list */
+/* add a timer to the pending list and schedule its expiration */
 static void link_timer( struct msg_queue *queue, struct timer *timer )
 {
-    struct list *ptr;
-
-    for (ptr = queue->pending_timers.next; ptr != &queue->pending_timers; ptr = ptr->next)
-    {
-        struct timer *t = LIST_ENTRY( ptr, struct timer, entry );
-        if (t->when >= timer->when) break;
-    }
-    list_add_before( ptr, &timer->entry );
+    list_add_tail( &queue->pending_timers, &timer->entry );
+    timer->timeout = add_timeout_user( timer->when, timer_callback, timer );
 }
 
 /* remove a timer from the queue timer list and free it */
 static void free_timer( struct msg_queue *queue, struct timer *timer )
 {
+    if (timer->timeout) remove_timeout_user( timer->timeout );
     list_remove( &timer->entry );
+    list_remove( &timer->hash_entry );
     free( timer );
-    set_next_timer( queue );
+    update_timer_bits( queue );
 }
 
 /* restart an expired timer */
@@ -1346,7 +1440,7 @@ static void restart_timer( struct msg_queue *queue, struct timer *timer )
     list_remove( &timer->entry );
     while (timer->when <= current_time) timer->when += (timeout_t)timer->rate * 10000;
     link_timer( queue, timer );
-    set_next_timer( queue );
+    update_timer_bits( queue );
 }
 
 /* find an expired timer matching the filtering parameters */
@@ -1370,16 +1464,26 @@ static struct timer *find_expired_timer( struct msg_queue *queue, user_handle_t
 }
 
 /* add a timer */
-static struct timer *set_timer( struct msg_queue *queue, unsigned int rate )
+static struct timer *set_timer( struct msg_queue *queue, unsigned int rate, user_handle_t win,
+                                unsigned int msg, lparam_t id )
 {
     struct timer *timer = mem_alloc( sizeof(*timer) );
     if (timer)
     {
-        timer->rate = max( rate, 1 );
-        timer->when = current_time + (timeout_t)timer->rate * 10000;
+        timer->queue = queue;
+        timer->rate  = max( rate, 1 );
+        timer->when  = current_time + (timeout_t)timer->rate * 10000;
+        timer->win   = win;
+        timer->msg   = msg;
+        timer->id    = id;
         link_timer( queue, timer );
-        /* check if we replaced the next timer */
-        if (list_head( &queue->pending_timers ) == &timer->entry) set_next_timer( queue );
+        if (!timer->timeout)
+        {
+            list_remove( &timer->entry );
+            free( timer );
+            return NULL;
+        }
+        list_add_head( get_timer_bucket( queue, win, msg, id ), &timer->hash_entry );
     }
     return timer;
 }
@@ -1741,7 +1845,7 @@ static int send_hook_ll_message( struct desktop *desktop, struct message *hardwa
     if (!(queue = hook_thread->queue)) return 0;
     if (is_queue_hung( queue )) return 0;
 
-    if (!(msg = mem_alloc( sizeof(*msg) ))) return 0;
+    if (!(msg = pool_alloc( &message_pool ))) return 0;
 
     msg->type      = MSG_HOOK_LL;
     msg->win       = 0;
@@ -2348,7 +2452,7 @@ void post_message( user_handle_t win, unsigned int message, lparam_t wparam, lpa
 
     if (!thread) return;
 
-    if (thread->queue && (msg = mem_alloc( sizeof(*msg) )))
+    if (thread->queue && (msg = pool_alloc( &message_pool )))
     {
         msg->type      = MSG_POSTED;
         msg->win       = get_user_full_handle( win );
@@ -2381,7 +2485,7 @@ void send_notify_message( user_handle_t win, unsigned int message, lparam_t wpar
 
     if (!thread) return;
 
-    if (thread->queue && (msg = mem_alloc( sizeof(*msg) )))
+    if (thread->queue && (msg = pool_alloc( &message_pool )))
     {
         msg->type      = MSG_NOTIFY;
         msg->win       = get_user_full_handle( win );
@@ -2409,7 +2513,7 @@ void post_win_event( struct thread *thread, unsigned int event,
 {
     struct message *msg;
 
-    if (thread->queue && (msg = mem_alloc( sizeof(*msg) )))
+    if (thread->queue && (msg = pool_alloc( &message_pool )))
     {
         struct winevent_msg_data *data;
 
@@ -2438,7 +2542,7 @@ void post_win_event( struct thread *thread, unsigned int event,
             set_queue_bits( thread->queue, QS_SENDMESSAGE );
         }
         else
-            free( msg );
+            pool_free( &message_pool, msg );
     }
 }
 
@@ -2569,7 +2673,7 @@ DECL_HANDLER(send_message)
         return;
     }
 
-    if ((msg = mem_alloc( sizeof(*msg) )))
+    if ((msg = pool_alloc( &message_pool )))
     {
         msg->type      = req->type;
         msg->win       = get_user_full_handle( req->win );
@@ -2584,7 +2688,7 @@ DECL_HANDLER(send_message)
 
         if (msg->data_size && !(msg->data = memdup( get_req_data(), msg->data_size )))
         {
-            free( msg );
+            pool_free( &message_pool, msg );
             release_object( thread );
             return;
         }
@@ -2620,7 +2724,7 @@ DECL_HANDLER(send_message)
         case MSG_HOOK_LL:  /* generated internally */
         default:
             set_error( STATUS_INVALID_PARAMETER );
-            free( msg );
+            pool_free( &message_pool, msg );
             break;
         }
     }
@@ -2738,7 +2842,10 @@ DECL_HANDLER(get_message)
     /* then check for posted messages */
     if ((filter & QS_POSTMESSAGE) &&
         get_posted_message( queue, queue->ignore_post_msg, get_win, req->get_first, req->get_last, req->flags, reply ))
+    {
+        if (req->prefetch) prefetch_posted_messages( queue, req, reply );
         return;
+    }
 
     if ((filter & QS_HOTKEY) && queue->hotkey_count &&
         req->get_first <= WM_HOTKEY && req->get_last >= WM_HOTKEY &&
@@ -2932,11 +3039,8 @@ DECL_HANDLER(set_win_timer)
         }
     }
 
-    if ((timer = set_timer( queue, req->rate )))
+    if ((timer = set_timer( queue, req->rate, win, req->msg, id )))
     {
-        timer->win    = win;
-        timer->msg    = req->msg;
-        timer->id     = id;
         timer->lparam = req->lparam;
         reply->id     = id;
     }
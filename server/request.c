@@ -944,7 +944,11 @@ static void close_socket_timeout( void *arg )
 {
     master_timeout = NULL;
     flush_registry();
-    if (debug_level) fprintf( stderr, "wineserver: exiting (pid=%ld)\n", (long) getpid() );
+    if (debug_level)
+    {
+        fprintf( stderr, "wineserver: exiting (pid=%ld)\n", (long) getpid() );
+        dump_pools();
+    }
 
 #ifdef DEBUG_OBJECTS
     close_objects();  /* shut down everything properly */
@@ -167,6 +167,7 @@ DECL_HANDLER(get_handle_unix_name);
 DECL_HANDLER(get_handle_fd);
 DECL_HANDLER(get_directory_cache_entry);
 DECL_HANDLER(get_shared_memory);
+DECL_HANDLER(compare_objects);
 DECL_HANDLER(flush);
 DECL_HANDLER(get_file_info);
 DECL_HANDLER(get_volume_info);
@@ -496,6 +497,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_get_handle_fd,
     (req_handler)req_get_directory_cache_entry,
     (req_handler)req_get_shared_memory,
+    (req_handler)req_compare_objects,
     (req_handler)req_flush,
     (req_handler)req_get_file_info,
     (req_handler)req_get_volume_info,
@@ -1131,7 +1133,11 @@ C_ASSERT( sizeof(struct get_directory_cache_entry_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_directory_cache_entry_reply, entry) == 8 );
 C_ASSERT( sizeof(struct get_directory_cache_entry_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_shared_memory_request, tid) == 12 );
-C_ASSERT( sizeof(struct get_shared_memory_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_shared_memory_request, process) == 16 );
+C_ASSERT( sizeof(struct get_shared_memory_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct compare_objects_request, first) == 12 );
+C_ASSERT( FIELD_OFFSET(struct compare_objects_request, second) == 16 );
+C_ASSERT( sizeof(struct compare_objects_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct flush_request, async) == 16 );
 C_ASSERT( sizeof(struct flush_request) == 56 );
 C_ASSERT( FIELD_OFFSET(struct flush_reply, event) == 8 );
@@ -1670,7 +1676,8 @@ C_ASSERT( FIELD_OFFSET(struct get_message_request, get_last) == 24 );
 C_ASSERT( FIELD_OFFSET(struct get_message_request, hw_id) == 28 );
 C_ASSERT( FIELD_OFFSET(struct get_message_request, wake_mask) == 32 );
 C_ASSERT( FIELD_OFFSET(struct get_message_request, changed_mask) == 36 );
-C_ASSERT( sizeof(struct get_message_request) == 40 );
+C_ASSERT( FIELD_OFFSET(struct get_message_request, prefetch) == 40 );
+C_ASSERT( sizeof(struct get_message_request) == 48 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, win) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, msg) == 12 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, wparam) == 16 );
@@ -1681,7 +1688,8 @@ C_ASSERT( FIELD_OFFSET(struct get_message_reply, y) == 40 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, time) == 44 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, active_hooks) == 48 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, total) == 52 );
-C_ASSERT( sizeof(struct get_message_reply) == 56 );
+C_ASSERT( FIELD_OFFSET(struct get_message_reply, prefetched) == 56 );
+C_ASSERT( sizeof(struct get_message_reply) == 64 );
 C_ASSERT( FIELD_OFFSET(struct reply_message_request, remove) == 12 );
 C_ASSERT( FIELD_OFFSET(struct reply_message_request, result) == 16 );
 C_ASSERT( sizeof(struct reply_message_request) == 24 );
@@ -79,6 +79,7 @@ struct thread_wait
     int                     flags;
     int                     in_kernel;  /* we can't timeout when winedevice is working on the thread's behalf */
     int                     abandoned;
+    int                     pooled;     /* allocated from the wait pool */
     enum select_op          select;
     client_ptr_t            key;        /* wait key for keyed events */
     client_ptr_t            cookie;     /* magic cookie to return to client */
@@ -87,6 +88,11 @@ struct thread_wait
     struct wait_queue_entry queues[1];
 };
 
+/* waits on a few objects are the common case, they are recycled through a pool */
+#define WAIT_POOL_COUNT 4
+
+static struct mem_pool wait_pool = MEM_POOL_INIT( "wait", FIELD_OFFSET(struct thread_wait, queues[WAIT_POOL_COUNT]) );
+
 /* asynchronous procedure calls */
 
 struct thread_apc
@@ -816,7 +822,8 @@ static unsigned int end_wait( struct thread *thread, unsigned int status )
     for (i = 0, entry = wait->queues; i < wait->count; i++, entry++)
         entry->obj->ops->remove_queue( entry->obj, entry );
     if (wait->user) remove_timeout_user( wait->user );
-    free( wait );
+    if (wait->pooled) pool_free( &wait_pool, wait );
+    else free( wait );
     return status;
 }
 
@@ -828,7 +835,10 @@ static int wait_on( const select_op_t *select_op, unsigned int count, struct obj
     struct wait_queue_entry *entry;
     unsigned int i;
 
-    if (!(wait = mem_alloc( FIELD_OFFSET(struct thread_wait, queues[count]) ))) return 0;
+    if (count <= WAIT_POOL_COUNT) wait = pool_alloc( &wait_pool );
+    else wait = mem_alloc( FIELD_OFFSET(struct thread_wait, queues[count]) );
+    if (!wait) return 0;
+    wait->pooled  = (count <= WAIT_POOL_COUNT);
     wait->next    = current->wait;
     wait->thread  = current;
     wait->count   = count;
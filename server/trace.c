@@ -1939,6 +1939,13 @@ static void dump_get_directory_cache_entry_reply( const struct get_directory_cac
 static void dump_get_shared_memory_request( const struct get_shared_memory_request *req )
 {
     fprintf( stderr, " tid=%04x", req->tid );
+    fprintf( stderr, ", process=%d", req->process );
+}
+
+static void dump_compare_objects_request( const struct compare_objects_request *req )
+{
+    fprintf( stderr, " first=%04x", req->first );
+    fprintf( stderr, ", second=%04x", req->second );
 }
 
 static void dump_flush_request( const struct flush_request *req )
@@ -2987,6 +2994,7 @@ static void dump_get_message_request( const struct get_message_request *req )
     fprintf( stderr, ", hw_id=%08x", req->hw_id );
     fprintf( stderr, ", wake_mask=%08x", req->wake_mask );
     fprintf( stderr, ", changed_mask=%08x", req->changed_mask );
+    fprintf( stderr, ", prefetch=%08x", req->prefetch );
 }
 
 static void dump_get_message_reply( const struct get_message_reply *req )
@@ -3001,6 +3009,7 @@ static void dump_get_message_reply( const struct get_message_reply *req )
     fprintf( stderr, ", time=%08x", req->time );
     fprintf( stderr, ", active_hooks=%08x", req->active_hooks );
     fprintf( stderr, ", total=%u", req->total );
+    fprintf( stderr, ", prefetched=%08x", req->prefetched );
     dump_varargs_message_data( ", data=", cur_size );
 }
 
@@ -4962,6 +4971,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_handle_fd_request,
     (dump_func)dump_get_directory_cache_entry_request,
     (dump_func)dump_get_shared_memory_request,
+    (dump_func)dump_compare_objects_request,
     (dump_func)dump_flush_request,
     (dump_func)dump_get_file_info_request,
     (dump_func)dump_get_volume_info_request,
@@ -5288,6 +5298,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_handle_fd_reply,
     (dump_func)dump_get_directory_cache_entry_reply,
     NULL,
+    NULL,
     (dump_func)dump_flush_reply,
     (dump_func)dump_get_file_info_reply,
     (dump_func)dump_get_volume_info_reply,
@@ -5614,6 +5625,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "get_handle_fd",
     "get_directory_cache_entry",
     "get_shared_memory",
+    "compare_objects",
     "flush",
     "get_file_info",
     "get_volume_info",
@@ -5972,6 +5984,7 @@ static const struct
     { "NOT_MAPPED_VIEW",             STATUS_NOT_MAPPED_VIEW },
     { "NOT_REGISTRY_FILE",           STATUS_NOT_REGISTRY_FILE },
     { "NOT_SAME_DEVICE",             STATUS_NOT_SAME_DEVICE },
+    { "NOT_SAME_OBJECT",             STATUS_NOT_SAME_OBJECT },
     { "NOT_SUPPORTED",               STATUS_NOT_SUPPORTED },
     { "NO_DATA_DETECTED",            STATUS_NO_DATA_DETECTED },
     { "NO_IMPERSONATION_TOKEN",      STATUS_NO_IMPERSONATION_TOKEN },
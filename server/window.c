@@ -33,6 +33,7 @@
 #include "winternl.h"
 
 #include "object.h"
+#include "file.h"
 #include "request.h"
 #include "thread.h"
 #include "process.h"
@@ -60,6 +61,7 @@ struct window
     struct window   *parent;          /* parent window */
     user_handle_t    owner;           /* owner of this window */
     struct list      children;        /* list of children in Z-order */
+    struct child_index *child_index;  /* spatial index of the children, built on demand */
     struct list      unlinked;        /* list of children not linked in the Z-order list */
     struct list      entry;           /* entry in parent's children list */
     user_handle_t    handle;          /* full handle for this window */
@@ -109,6 +111,22 @@ struct window
 #define PAINT_DELAYED_ERASE      0x0080  /* still needs erase after WM_ERASEBKGND */
 #define PAINT_PIXEL_FORMAT_CHILD 0x0100  /* at least one child has a custom pixel format */
 
+/* grid of the children visible rectangles, used to speed up hit testing */
+struct child_index
+{
+    rectangle_t     bounds;           /* bounding rectangle of all the cells */
+    int             cell_width;       /* width of a grid cell */
+    int             cell_height;      /* height of a grid cell */
+    int             cols;             /* number of grid columns */
+    int             rows;             /* number of grid rows */
+    unsigned int   *cells;            /* offset of each cell in the windows array */
+    struct window **windows;          /* windows overlapping each cell, in Z-order */
+};
+
+#define CHILD_INDEX_MIN_COUNT 64      /* minimum number of children to build an index */
+#define CHILD_INDEX_MAX_SIZE  64      /* maximum number of grid rows and columns */
+#define CHILD_INDEX_MAX_RATIO 16      /* maximum average number of cells per window */
+
 /* growable array of user handles */
 struct user_handle_array
 {
@@ -189,6 +207,157 @@ static unsigned int get_monitor_dpi( struct window *win )
     return win->dpi ? win->dpi : USER_DEFAULT_SCREEN_DPI;
 }
 
+/* get the entry of a window in the shared memory window table */
+static inline shm_window_t *get_shm_window( struct window *win )
+{
+    if (!shmglobal) return NULL;
+    return &shmglobal->windows[((win->handle & 0xffff) - FIRST_USER_HANDLE) >> 1];
+}
+
+/* publish the window information in the shared memory window table */
+static void update_shm_window( struct window *win )
+{
+    shm_window_t *shm_win = get_shm_window( win );
+
+    if (!shm_win) return;
+
+    /* readers retry while the sequence counter is odd or has changed */
+    interlocked_xchg_add( (int *)&shmglobal->window_seq, 1 );
+    shm_win->handle   = win->handle;
+    shm_win->parent   = win->parent ? win->parent->handle : 0;
+    shm_win->owner    = win->owner;
+    shm_win->pid      = win->thread ? get_process_id( win->thread->process ) : 0;
+    shm_win->tid      = win->thread ? get_thread_id( win->thread ) : 0;
+    shm_win->style    = win->style;
+    shm_win->ex_style = win->ex_style;
+    shm_win->dpi      = win->dpi;
+    shm_win->window   = win->window_rect;
+    shm_win->client   = win->client_rect;
+    interlocked_xchg_add( (int *)&shmglobal->window_seq, 1 );
+}
+
+/* remove a window from the shared memory window table */
+static void clear_shm_window( struct window *win )
+{
+    shm_window_t *shm_win = get_shm_window( win );
+
+    if (!shm_win) return;
+
+    interlocked_xchg_add( (int *)&shmglobal->window_seq, 1 );
+    memset( shm_win, 0, sizeof(*shm_win) );
+    interlocked_xchg_add( (int *)&shmglobal->window_seq, 1 );
+}
+
+/* free the spatial index of the children of a window */
+static void invalidate_child_index( struct window *parent )
+{
+    struct child_index *index;
+
+    if (!parent || !(index = parent->child_index)) return;
+    free( index->cells );
+    free( index->windows );
+    free( index );
+    parent->child_index = NULL;
+}
+
+/* get the range of grid cells covered by a rectangle */
+static inline void get_child_index_cells( const struct child_index *index, const rectangle_t *rect,
+                                          int *col_start, int *col_end, int *row_start, int *row_end )
+{
+    *col_start = (rect->left - index->bounds.left) / index->cell_width;
+    *col_end   = (rect->right - 1 - index->bounds.left) / index->cell_width;
+    *row_start = (rect->top - index->bounds.top) / index->cell_height;
+    *row_end   = (rect->bottom - 1 - index->bounds.top) / index->cell_height;
+}
+
+/* get the spatial index of the children of a window, building it if needed */
+/* returns NULL if the children should simply be walked in Z-order instead */
+static struct child_index *get_child_index( struct window *parent )
+{
+    struct child_index *index;
+    struct window *ptr;
+    rectangle_t bounds;
+    unsigned int count = 0, total = 0, cell;
+    int size, col, row, col_start, col_end, row_start, row_end;
+
+    if (parent->child_index) return parent->child_index;
+
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    {
+        if (ptr->dpi != parent->dpi) return NULL;  /* points would need to be mapped */
+        if (is_rect_empty( &ptr->visible_rect )) continue;
+        if (!count++) bounds = ptr->visible_rect;
+        bounds.left   = min( bounds.left, ptr->visible_rect.left );
+        bounds.top    = min( bounds.top, ptr->visible_rect.top );
+        bounds.right  = max( bounds.right, ptr->visible_rect.right );
+        bounds.bottom = max( bounds.bottom, ptr->visible_rect.bottom );
+    }
+    if (count < CHILD_INDEX_MIN_COUNT) return NULL;
+
+    if (!(index = mem_alloc( sizeof(*index) ))) return NULL;
+    for (size = 1; size < CHILD_INDEX_MAX_SIZE && size * size < count; size++) ;
+    index->bounds      = bounds;
+    index->cell_width  = (bounds.right - bounds.left + size - 1) / size;
+    index->cell_height = (bounds.bottom - bounds.top + size - 1) / size;
+    index->cols        = (bounds.right - bounds.left + index->cell_width - 1) / index->cell_width;
+    index->rows        = (bounds.bottom - bounds.top + index->cell_height - 1) / index->cell_height;
+    index->windows     = NULL;
+    if (!(index->cells = mem_alloc( (index->cols * index->rows + 1) * sizeof(*index->cells) )))
+    {
+        free( index );
+        return NULL;
+    }
+    memset( index->cells, 0, (index->cols * index->rows + 1) * sizeof(*index->cells) );
+
+    /* count the windows in each cell */
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    {
+        if (is_rect_empty( &ptr->visible_rect )) continue;
+        get_child_index_cells( index, &ptr->visible_rect, &col_start, &col_end, &row_start, &row_end );
+        for (row = row_start; row <= row_end; row++)
+            for (col = col_start; col <= col_end; col++)
+                index->cells[row * index->cols + col]++;
+        total += (row_end - row_start + 1) * (col_end - col_start + 1);
+        if (total > count * CHILD_INDEX_MAX_RATIO) break;  /* too many overlapping windows */
+    }
+    if (total > count * CHILD_INDEX_MAX_RATIO || !(index->windows = mem_alloc( total * sizeof(*index->windows) )))
+    {
+        free( index->cells );
+        free( index );
+        return NULL;
+    }
+
+    /* store the end offset of each cell, and fill them backwards to keep the Z-order */
+    for (cell = 1; cell <= index->cols * index->rows; cell++) index->cells[cell] += index->cells[cell - 1];
+    LIST_FOR_EACH_ENTRY_REV( ptr, &parent->children, struct window, entry )
+    {
+        if (is_rect_empty( &ptr->visible_rect )) continue;
+        get_child_index_cells( index, &ptr->visible_rect, &col_start, &col_end, &row_start, &row_end );
+        for (row = row_start; row <= row_end; row++)
+            for (col = col_start; col <= col_end; col++)
+                index->windows[--index->cells[row * index->cols + col]] = ptr;
+    }
+    parent->child_index = index;
+    return index;
+}
+
+/* get the children that may contain a given point (in parent-relative coords), in Z-order */
+static struct window **get_child_index_windows( const struct child_index *index, int x, int y,
+                                                unsigned int *count )
+{
+    unsigned int cell;
+
+    if (!point_in_rect( &index->bounds, x, y ))
+    {
+        *count = 0;
+        return NULL;
+    }
+    cell = (y - index->bounds.top) / index->cell_height * index->cols +
+           (x - index->bounds.left) / index->cell_width;
+    *count = index->cells[cell + 1] - index->cells[cell];
+    return index->windows + index->cells[cell];
+}
+
 /* link a window at the right place in the siblings list */
 static void link_window( struct window *win, struct window *previous )
 {
@@ -242,6 +411,8 @@ static void link_window( struct window *win, struct window *previous )
     }
 
     win->is_linked = 1;
+    invalidate_child_index( win->parent );
+    update_shm_window( win );
 }
 
 /* change the parent of a window (or unlink the window if the new parent is NULL) */
@@ -261,6 +432,7 @@ static int set_parent_window( struct window *win, struct window *parent )
 
     if (parent)
     {
+        invalidate_child_index( win->parent );
         win->parent = parent;
         link_window( win, WINPTR_TOP );
 
@@ -268,6 +440,7 @@ static int set_parent_window( struct window *win, struct window *parent )
         {
             win->dpi = parent->dpi;
             win->dpi_awareness = parent->dpi_awareness;
+            invalidate_child_index( win );
         }
 
         /* if parent belongs to a different thread and the window isn't */
@@ -277,12 +450,14 @@ static int set_parent_window( struct window *win, struct window *parent )
 
         if (win->paint_flags & (PAINT_HAS_PIXEL_FORMAT | PAINT_PIXEL_FORMAT_CHILD))
             update_pixel_format_flags( win );
+        update_shm_window( win );
     }
     else  /* move it to parent unlinked list */
     {
         list_remove( &win->entry );  /* unlink it from the previous location */
         list_add_head( &win->parent->unlinked, &win->entry );
         win->is_linked = 0;
+        invalidate_child_index( win->parent );
     }
     return 1;
 }
@@ -422,6 +597,7 @@ static void detach_window_thread( struct window *win )
     /* destroyed when the desktop ref count reaches zero */
     release_object( win->desktop );
     win->thread = NULL;
+    update_shm_window( win );
 }
 
 /* get the process owning the top window of a given desktop */
@@ -495,6 +671,7 @@ static struct window *create_window( struct window *parent, struct window *owner
     win->class          = class;
     win->atom           = atom;
     win->last_active    = win->handle;
+    win->child_index    = NULL;
     win->win_region     = NULL;
     win->layer_region   = NULL;
     win->update_region  = NULL;
@@ -756,52 +933,83 @@ static unsigned int get_children_windows( struct window *parent, atom_t atom, th
     return count;
 }
 
+static struct window *child_window_from_point( struct window *parent, int x, int y );
+
+/* find the window containing the given point (in parent-relative coords) within a child */
+/* returns NULL if the point is not in the child */
+static struct window *window_from_point_in_child( struct window *parent, struct window *ptr,
+                                                  int x, int y )
+{
+    if (!is_point_in_window( ptr, &x, &y, parent->dpi )) return NULL;
+
+    /* if window is minimized or disabled, return at once */
+    if (ptr->style & (WS_MINIMIZE|WS_DISABLED)) return ptr;
+
+    /* if point is not in client area, return at once */
+    if (!point_in_rect( &ptr->client_rect, x, y )) return ptr;
+
+    return child_window_from_point( ptr, x - ptr->client_rect.left, y - ptr->client_rect.top );
+}
+
 /* find child of 'parent' that contains the given point (in parent-relative coords) */
 static struct window *child_window_from_point( struct window *parent, int x, int y )
 {
-    struct window *ptr;
+    struct child_index *index = get_child_index( parent );
+    struct window *ptr, *ret, **windows;
+    unsigned int i, count;
 
-    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    if (index)
     {
-        int x_child = x, y_child = y;
+        windows = get_child_index_windows( index, x, y, &count );
+        for (i = 0; i < count; i++)
+            if ((ret = window_from_point_in_child( parent, windows[i], x, y ))) return ret;
+        return parent;
+    }
 
-        if (!is_point_in_window( ptr, &x_child, &y_child, parent->dpi )) continue;  /* skip it */
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+        if ((ret = window_from_point_in_child( parent, ptr, x, y ))) return ret;
+    return parent;  /* not found any child */
+}
 
-        /* if window is minimized or disabled, return at once */
-        if (ptr->style & (WS_MINIMIZE|WS_DISABLED)) return ptr;
+static int get_window_children_from_point( struct window *parent, int x, int y,
+                                           struct user_handle_array *array );
 
-        /* if point is not in client area, return at once */
-        if (!point_in_rect( &ptr->client_rect, x_child, y_child )) return ptr;
+/* add a child and its children to the array if they contain the given point */
+static int add_child_from_point( struct window *parent, struct window *ptr, int x, int y,
+                                 struct user_handle_array *array )
+{
+    if (!is_point_in_window( ptr, &x, &y, parent->dpi )) return 1;  /* skip it */
 
-        return child_window_from_point( ptr, x_child - ptr->client_rect.left,
-                                        y_child - ptr->client_rect.top );
+    /* if point is in client area, and window is not minimized or disabled, check children */
+    if (!(ptr->style & (WS_MINIMIZE|WS_DISABLED)) && point_in_rect( &ptr->client_rect, x, y ))
+    {
+        if (!get_window_children_from_point( ptr, x - ptr->client_rect.left,
+                                             y - ptr->client_rect.top, array ))
+            return 0;
     }
-    return parent;  /* not found any child */
+
+    /* now add window to the array */
+    return add_handle_to_array( array, ptr->handle );
 }
 
 /* find all children of 'parent' that contain the given point */
 static int get_window_children_from_point( struct window *parent, int x, int y,
                                            struct user_handle_array *array )
 {
-    struct window *ptr;
+    struct child_index *index = get_child_index( parent );
+    struct window *ptr, **windows;
+    unsigned int i, count;
 
-    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+    if (index)
     {
-        int x_child = x, y_child = y;
-
-        if (!is_point_in_window( ptr, &x_child, &y_child, parent->dpi )) continue;  /* skip it */
-
-        /* if point is in client area, and window is not minimized or disabled, check children */
-        if (!(ptr->style & (WS_MINIMIZE|WS_DISABLED)) && point_in_rect( &ptr->client_rect, x_child, y_child ))
-        {
-            if (!get_window_children_from_point( ptr, x_child - ptr->client_rect.left,
-                                                 y_child - ptr->client_rect.top, array ))
-                return 0;
-        }
-
-        /* now add window to the array */
-        if (!add_handle_to_array( array, ptr->handle )) return 0;
+        windows = get_child_index_windows( index, x, y, &count );
+        for (i = 0; i < count; i++)
+            if (!add_child_from_point( parent, windows[i], x, y, array )) return 0;
+        return 1;
     }
+
+    LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
+        if (!add_child_from_point( parent, ptr, x, y, array )) return 0;
     return 1;
 }
 
@@ -970,13 +1178,19 @@ static struct region *clip_children( struct window *parent, struct window *last,
 {
     struct window *ptr;
     struct region *tmp = create_empty_region();
+    rectangle_t extents, rect;
 
     if (!tmp) return NULL;
+    get_region_extents( region, &extents );
     LIST_FOR_EACH_ENTRY( ptr, &parent->children, struct window, entry )
     {
         if (ptr == last) break;
         if (!(ptr->style & WS_VISIBLE)) continue;
         if (ptr->ex_style & WS_EX_TRANSPARENT) continue;
+        /* skip children that don't overlap what is left of the region */
+        rect = ptr->visible_rect;
+        offset_rect( &rect, offset_x, offset_y );
+        if (!intersect_rect( &rect, &rect, &extents )) continue;
         set_region_rect( tmp, &ptr->visible_rect );
         if (ptr->win_region && !intersect_window_region( tmp, ptr ))
         {
@@ -986,6 +1200,7 @@ static struct region *clip_children( struct window *parent, struct window *last,
         offset_region( tmp, offset_x, offset_y );
         if (!(region = subtract_region( region, region, tmp ))) break;
         if (is_region_empty( region )) break;
+        get_region_extents( region, &extents );
     }
     free_region( tmp );
     return region;
@@ -1704,9 +1919,12 @@ static void set_window_pos( struct window *win, struct window *previous,
     win->visible_rect = *visible_rect;
     win->surface_rect = *surface_rect;
     win->client_rect  = *client_rect;
+    if (memcmp( visible_rect, &old_visible_rect, sizeof(old_visible_rect) ))
+        invalidate_child_index( win->parent );
     if (!(swp_flags & SWP_NOZORDER) && win->parent) link_window( win, previous );
     if (swp_flags & SWP_SHOWWINDOW) win->style |= WS_VISIBLE;
     else if (swp_flags & SWP_HIDEWINDOW) win->style &= ~WS_VISIBLE;
+    update_shm_window( win );
 
     /* keep children at the same position relative to top right corner when the parent is mirrored */
     if (win->ex_style & WS_EX_LAYOUTRTL)
@@ -1721,7 +1939,9 @@ static void set_window_pos( struct window *win, struct window *previous,
             offset_rect( &child->visible_rect, new_size - old_size, 0 );
             offset_rect( &child->surface_rect, new_size - old_size, 0 );
             offset_rect( &child->client_rect, new_size - old_size, 0 );
+            update_shm_window( child );
         }
+        invalidate_child_index( win );
     }
 
     /* reset cursor clip rectangle when the desktop changes size */
@@ -1916,6 +2136,8 @@ void destroy_window( struct window *win )
     cleanup_clipboard_window( win->desktop, win->handle );
     free_user_handle( win->handle );
     destroy_properties( win );
+    invalidate_child_index( win );
+    invalidate_child_index( win->parent );
     list_remove( &win->entry );
     if (is_desktop_window(win))
     {
@@ -1930,6 +2152,7 @@ void destroy_window( struct window *win )
     }
 
     detach_window_thread( win );
+    clear_shm_window( win );
     if (win->win_region) free_region( win->win_region );
     if (win->layer_region) free_region( win->layer_region );
     if (win->update_region) free_region( win->update_region );
@@ -1980,6 +2203,8 @@ DECL_HANDLER(create_window)
         win->dpi = req->dpi;
     }
 
+    update_shm_window( win );
+
     reply->handle    = win->handle;
     reply->parent    = win->parent ? win->parent->handle : 0;
     reply->owner     = win->owner;
@@ -2041,6 +2266,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->top_window );
             desktop->top_window->style  = WS_POPUP | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_shm_window( desktop->top_window );
         }
     }
 
@@ -2053,6 +2279,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->msg_window );
             desktop->msg_window->style = WS_POPUP | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_shm_window( desktop->msg_window );
         }
     }
 
@@ -2088,6 +2315,7 @@ DECL_HANDLER(set_window_owner)
 
     reply->prev_owner = win->owner;
     reply->full_owner = win->owner = owner ? owner->handle : 0;
+    update_shm_window( win );
 }
 
 
@@ -2162,6 +2390,7 @@ DECL_HANDLER(set_window_info)
 
     /* changing window style triggers a non-client paint */
     if (req->flags & SET_WIN_STYLE) win->paint_flags |= PAINT_NONCLIENT;
+    if (req->flags & (SET_WIN_STYLE | SET_WIN_EXSTYLE)) update_shm_window( win );
 }
 
 
@@ -2702,6 +2931,7 @@ DECL_HANDLER(update_window_zorder)
         {
             list_remove( &win->entry );
             list_add_before( &ptr->entry, &win->entry );
+            invalidate_child_index( win->parent );
         }
         break;
     }